@@ -390,6 +390,7 @@ fast_downward_plugin(
     NAME PDR_SEARCH
     HELP "Property-directed reachability search algorithm"
     SOURCES
+        search_engines/pdr_portfolio
         search_engines/pdr_search
     DEPENDS ORDERED_SET PDR
     DEPENDENCY_ONLY
@@ -796,9 +797,19 @@ fast_downward_plugin(
     NAME PDR
     HELP "Plugin containing the code for PDR"
     SOURCES
+        pdr/clause-database
         pdr/data-structures
+        pdr/goal-states
         pdr/heuristic
+        pdr/hmax
+        pdr/mutex
         pdr/pattern-database
+        pdr/reasons
+        pdr/sat-extend
+        pdr/sat-solver
+        pdr/shared-clauses
+        pdr/successors
+    DEPENDS PDBS
     DEPENDENCY_ONLY
 )
 
@@ -0,0 +1,147 @@
+#include "clause-database.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace pdr_search
+{
+  namespace
+  {
+    // The bump amount grows by 1 / ACTIVITY_DECAY per iteration.
+    const double ACTIVITY_DECAY = 0.8;
+    const double MAX_ACTIVITY = 1e100;
+
+    struct Candidate
+    {
+      std::size_t layer;
+      const LiteralSet *clause;
+      double activity;
+      std::size_t stamp;
+    };
+  }
+
+  ClauseDatabase::ClauseDatabase(std::size_t limit) :
+      memory_limit(limit),
+      activity_increment(1),
+      recent_stamp(0),
+      num_weakened_layers(0),
+      memory_usage(0),
+      num_reductions(0),
+      num_subsumed(0),
+      num_evicted(0)
+  {
+  }
+
+  std::size_t ClauseDatabase::get_memory_usage(const std::vector<std::shared_ptr<Layer>> &layers) const
+  {
+    std::size_t usage = 0;
+    for (const auto &L : layers)
+    {
+      usage += L->get_delta().get_memory_usage();
+    }
+    return usage;
+  }
+
+  void ClauseDatabase::bump(const Layer &L, std::vector<const LiteralSet *> &blocking)
+  {
+    for (const LiteralSet *c : blocking)
+    {
+      L.bump_activity(*c, activity_increment);
+    }
+    blocking.clear();
+  }
+
+  void ClauseDatabase::age(const std::vector<std::shared_ptr<Layer>> &layers)
+  {
+    activity_increment /= ACTIVITY_DECAY;
+    if (activity_increment > MAX_ACTIVITY)
+    {
+      for (const auto &L : layers)
+      {
+        L->get_delta().scale_activities(1 / MAX_ACTIVITY);
+      }
+      activity_increment /= MAX_ACTIVITY;
+    }
+  }
+
+  std::size_t ClauseDatabase::reduce(const std::vector<std::shared_ptr<Layer>> &layers)
+  {
+    std::size_t evicted = 0;
+    memory_usage = get_memory_usage(layers);
+    if (memory_usage > memory_limit)
+    {
+      num_reductions += 1;
+      // Simplify the children first, their clauses subsume the clauses
+      // of the parents.
+      for (std::size_t i = layers.size(); i-- > 0;)
+      {
+        num_subsumed += layers[i]->simplify();
+      }
+      memory_usage = get_memory_usage(layers);
+    }
+
+    if (memory_usage > memory_limit)
+    {
+      std::vector<Candidate> candidates;
+      for (std::size_t i = 0; i < layers.size(); i++)
+      {
+        const LayerDelta &delta = layers[i]->get_delta();
+        for (std::size_t position = 0; position < delta.get_num_positions(); position++)
+        {
+          const LiteralSet *c = delta.get_clause(position);
+          if (c != nullptr && c->size() > 1 && delta.get_stamp(position) < recent_stamp)
+          {
+            candidates.push_back(Candidate{i, c, delta.get_activity(position), delta.get_stamp(position)});
+          }
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.activity != b.activity)
+        {
+          return a.activity < b.activity;
+        }
+        if (a.clause->size() != b.clause->size())
+        {
+          return a.clause->size() > b.clause->size();
+        }
+        return a.stamp < b.stamp;
+      });
+
+      // Evicting down to the limit would let the next iteration exceed it again.
+      std::size_t target = memory_limit / 4 * 3;
+      std::size_t freed = 0;
+      for (const Candidate &candidate : candidates)
+      {
+        if (memory_usage - freed <= target)
+        {
+          break;
+        }
+        freed += LayerDelta::get_clause_memory(*candidate.clause);
+        // erase destroys the stored clause, it is not used afterwards
+        layers[candidate.layer]->remove_set(*candidate.clause);
+        num_weakened_layers = std::max(num_weakened_layers, candidate.layer + 1);
+        evicted += 1;
+      }
+      num_evicted += evicted;
+      memory_usage = get_memory_usage(layers);
+    }
+
+    age(layers);
+    recent_stamp = LayerDelta::get_next_stamp();
+    return evicted;
+  }
+
+  bool ClauseDatabase::is_weakened(std::size_t i) const
+  {
+    return i < num_weakened_layers;
+  }
+
+  void ClauseDatabase::print_statistics() const
+  {
+    std::cout << "Clause memory limit: " << memory_limit / 1024 << " KB" << std::endl;
+    std::cout << "Clause memory: " << memory_usage / 1024 << " KB" << std::endl;
+    std::cout << "Clause database reductions: " << num_reductions << std::endl;
+    std::cout << "Removed subsumed clauses: " << num_subsumed << std::endl;
+    std::cout << "Evicted clauses: " << num_evicted << std::endl;
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef PDR_CLAUSE_DATABASE_H
+#define PDR_CLAUSE_DATABASE_H
+
+#include "data-structures.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pdr_search
+{
+  // Keeps the clauses of the layers within a memory limit.
+  //
+  // Every clause has an activity (stored in its delta) that is bumped
+  // whenever the clause blocks a successor in extend. The amount of a
+  // bump grows with every iteration, so clauses that were only useful in
+  // early iterations age.
+  //
+  // Once the layers exceed the limit, the subsumed clauses are removed
+  // first (Layer::simplify), which does not change the layers. If that is
+  // not enough, the clauses with the smallest activity are evicted, long
+  // ones first, until the layers fit in three quarters of the limit.
+  // Unit clauses are never evicted, they are cheap and keep L0 exact,
+  // and neither are the clauses of the last iteration, they did not have
+  // the time to block anything yet.
+  //
+  // Evicting a clause from the delta of Lj removes it from Lj and all
+  // layers below, so L_{i+1} ⊆ L_i still holds and every layer still
+  // contains the states it has to contain. Only the clauses of the layers
+  // above a weakened layer may no longer be inductive relative to it, so
+  // Li = Li+1 does not prove unsolvability anymore if Li is weakened
+  // (see PDRSearch::is_fixpoint).
+  class ClauseDatabase
+  {
+  private:
+    std::size_t memory_limit;
+    double activity_increment;
+    // Clauses with a stamp from here on were added in the last iteration.
+    std::size_t recent_stamp;
+    // The layers below this index were weakened by an eviction.
+    std::size_t num_weakened_layers;
+    std::size_t memory_usage;
+    std::size_t num_reductions;
+    std::size_t num_subsumed;
+    std::size_t num_evicted;
+
+    std::size_t get_memory_usage(const std::vector<std::shared_ptr<Layer>> &layers) const;
+    void age(const std::vector<std::shared_ptr<Layer>> &layers);
+
+  public:
+    // The limit is given in bytes.
+    ClauseDatabase(std::size_t memory_limit);
+
+    // Bumps the activity of the blocking clauses, which are clauses of L,
+    // and clears them.
+    void bump(const Layer &L, std::vector<const LiteralSet *> &blocking);
+    // Called after every iteration: removes subsumed clauses and evicts
+    // clauses if the layers exceed the memory limit, then ages the
+    // activities. Returns the number of evicted clauses.
+    std::size_t reduce(const std::vector<std::shared_ptr<Layer>> &layers);
+    // Returns true if clauses were evicted from Li, then the clauses of
+    // Li+1 may not be inductive relative to Li.
+    bool is_weakened(std::size_t i) const;
+    void print_statistics() const;
+  };
+}
+
+#endif
@@ -1,27 +1,146 @@
 #include "data-structures.h"
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <iterator>
 #include <ostream>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace pdr_search
 {
-  Literal::Literal(int var, int val, const FactProxy &f) : variable(var), value(val), fact(f)
+  namespace
+  {
+    int count_trailing_zeros(uint64_t word)
+    {
+      assert(word != 0);
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward64(&index, word);
+      return static_cast<int>(index);
+#else
+      return __builtin_ctzll(word);
+#endif
+    }
+
+    std::size_t count_ones(uint64_t word)
+    {
+#if defined(_MSC_VER)
+      return static_cast<std::size_t>(__popcnt64(word));
+#else
+      return static_cast<std::size_t>(__builtin_popcountll(word));
+#endif
+    }
+
+    // Random key of a fact for the Zobrist hash of literal sets (splitmix64).
+    uint64_t get_fact_key(std::size_t index)
+    {
+      uint64_t key = index + 0x9e3779b97f4a7c15ULL;
+      key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+      return key ^ (key >> 31);
+    }
+
+    // Bytes of a clause stored in a delta: its bitmap and its node in the
+    // positions of the delta.
+    std::size_t get_stored_clause_memory()
+    {
+      return sizeof(LiteralSet) + 2 * FactIndex::get_num_words() * sizeof(uint64_t) +
+          sizeof(std::size_t) + 2 * sizeof(void *);
+    }
+
+    // Bytes of a log position of a delta: the clause pointer, its stamp,
+    // signature and activity.
+    std::size_t get_position_memory()
+    {
+      return sizeof(const LiteralSet *) + sizeof(std::size_t) + sizeof(uint64_t) + sizeof(double);
+    }
+
+    // XOR of the keys of the facts set in word w of a bitmap half.
+    uint64_t get_word_hash(uint64_t word, std::size_t w)
+    {
+      uint64_t hash = 0;
+      for (; word != 0; word &= word - 1)
+      {
+        hash ^= get_fact_key(w * 64 + count_trailing_zeros(word));
+      }
+      return hash;
+    }
+  }
+
+  const AbstractTask *FactIndex::task = nullptr;
+  std::vector<int> FactIndex::variable_offsets;
+  std::vector<FactPair> FactIndex::facts;
+  std::size_t FactIndex::num_words = 0;
+  std::atomic<std::size_t> LayerDelta::next_stamp(0);
+
+  void FactIndex::initialize(const AbstractTask &t)
   {
+    task = &t;
+    variable_offsets.clear();
+    facts.clear();
+    TaskProxy task_proxy(t);
+    for (const auto &var : task_proxy.get_variables())
+    {
+      variable_offsets.push_back(facts.size());
+      for (int value = 0; value < var.get_domain_size(); value++)
+      {
+        facts.emplace_back(var.get_id(), value);
+      }
+    }
+    num_words = (facts.size() + 63) / 64;
   }
-  Literal::Literal(int var, int val, bool pos, const FactProxy &f) : variable(var), value(val), positive(pos), fact(f)
+
+  std::size_t FactIndex::get_num_facts()
   {
+    return facts.size();
   }
-  Literal::Literal(const Literal &l) : variable(l.variable), value(l.value), positive(l.positive), fact(l.fact),
-    hash_cache(l.hash_cache)
+
+  std::size_t FactIndex::get_num_words()
   {
+    return num_words;
   }
-  Literal &Literal::operator=(const Literal &l)
+
+  int FactIndex::get_num_variables()
+  {
+    return variable_offsets.size();
+  }
+
+  int FactIndex::get_index(int variable, int value)
+  {
+    assert(variable >= 0 && variable < static_cast<int>(variable_offsets.size()));
+    return variable_offsets[variable] + value;
+  }
+
+  int FactIndex::get_domain_size(int variable)
+  {
+    assert(variable >= 0 && variable < static_cast<int>(variable_offsets.size()));
+    if (variable + 1 < static_cast<int>(variable_offsets.size()))
+    {
+      return variable_offsets[variable + 1] - variable_offsets[variable];
+    }
+    return facts.size() - variable_offsets[variable];
+  }
+
+  const FactPair &FactIndex::get_fact(int index)
+  {
+    return facts[index];
+  }
+
+  std::string FactIndex::get_name(int variable, int value)
+  {
+    assert(task);
+    return task->get_fact_name(FactPair(variable, value));
+  }
+
+  Literal::Literal(int var, int val) : variable(var), value(val)
+  {
+  }
+  Literal::Literal(int var, int val, bool pos) : variable(var), value(val), positive(pos)
   {
-    variable = l.variable;
-    value = l.value;
-    fact = l.fact;
-    hash_cache = l.hash_cache;
-    return *this;
   }
   bool Literal::operator==(const Literal &l) const
   {
@@ -43,9 +162,21 @@ namespace pdr_search
   {
     return positive;
   }
+  int Literal::get_variable() const
+  {
+    return variable;
+  }
+  int Literal::get_value() const
+  {
+    return value;
+  }
+  int Literal::get_fact_index() const
+  {
+    return FactIndex::get_index(variable, value);
+  }
   std::ostream &operator<<(std::ostream &os, const Literal &l)
   {
-    auto name = l.fact.get_name();
+    auto name = FactIndex::get_name(l.variable, l.value);
     auto color = (l.positive) ? COLOR_GREEN : COLOR_YELLOW;
     os << color << (l.positive ? "" : "¬") << "(";
     if (name.size() > 0)
@@ -58,34 +189,31 @@ namespace pdr_search
 
   Literal Literal::invert() const
   {
-    return Literal(variable, value, !positive, fact);
+    return Literal(variable, value, !positive);
   }
 
   Literal Literal::neg() const
   {
-    return Literal(variable, value, false, fact);
+    return Literal(variable, value, false);
   }
   Literal Literal::pos() const
   {
-    return Literal(variable, value, true, fact);
+    return Literal(variable, value, true);
   }
 
   Literal Literal::from_fact(FactProxy fp)
   {
     auto factPair = fp.get_pair();
-    return Literal(factPair.var, factPair.value, fp);
+    return Literal(factPair.var, factPair.value);
   }
 
   std::size_t Literal::hash() const 
   {
-    if (hash_cache == 0) {
-        utils::HashState hs;
-        utils::feed(hs, variable);
-        utils::feed(hs, value);
-        utils::feed(hs, positive);
-        hash_cache = hs.get_hash64();
-    }
-    return hash_cache;
+    utils::HashState hs;
+    utils::feed(hs, variable);
+    utils::feed(hs, value);
+    utils::feed(hs, positive);
+    return hs.get_hash64();
   }
 
   std::size_t LiteralHash::operator()(const Literal &v) const
@@ -93,33 +221,86 @@ namespace pdr_search
      return v.hash(); 
   }
 
-  LiteralSet::LiteralSet(SetType type) : set_type(type)
+  LiteralSet::const_iterator::const_iterator(const LiteralSet *s, std::size_t w) : set(s), word(w), remaining(0)
+  {
+    if (word < set->bits.size())
+    {
+      remaining = set->bits[word];
+      skip_empty_words();
+    }
+  }
+
+  void LiteralSet::const_iterator::skip_empty_words()
   {
+    while (remaining == 0 && ++word < set->bits.size())
+    {
+      remaining = set->bits[word];
+    }
   }
-  LiteralSet::LiteralSet(const Literal &v, SetType type) : set_type(type)
+
+  Literal LiteralSet::const_iterator::operator*() const
   {
-    literals.insert(v);
+    std::size_t num_words = FactIndex::get_num_words();
+    bool positive = word < num_words;
+    int index = (positive ? word : word - num_words) * 64 + count_trailing_zeros(remaining);
+    const FactPair &fact = FactIndex::get_fact(index);
+    return Literal(fact.var, fact.value, positive);
   }
-  LiteralSet::LiteralSet(const LiteralSet &s) : set_type(s.set_type), literals(s.literals)
+
+  LiteralSet::const_iterator &LiteralSet::const_iterator::operator++()
   {
+    // clear lowest set bit
+    remaining &= remaining - 1;
+    skip_empty_words();
+    return *this;
   }
 
-  LiteralSet::LiteralSet(const std::unordered_set<Literal, LiteralHash> &init_literals, SetType type) : set_type(type), literals(init_literals)
+  bool LiteralSet::const_iterator::operator==(const const_iterator &it) const
   {
+    return set == it.set && word == it.word && remaining == it.remaining;
   }
 
-  LiteralSet &LiteralSet::operator=(const LiteralSet &s)
+  bool LiteralSet::const_iterator::operator!=(const const_iterator &it) const
   {
-    literals = s.literals;
-    set_type = s.set_type;
-    return *this;
+    return !(*this == it);
+  }
+
+  LiteralSet::LiteralSet(SetType type) : set_type(type), bits(2 * FactIndex::get_num_words(), 0), num_literals(0),
+                                          positive_hash(0), negative_hash(0)
+  {
+  }
+
+  LiteralSet::LiteralSet(const Literal &v, SetType type) : LiteralSet(type)
+  {
+    add_literal(v);
+  }
+
+  LiteralSet::LiteralSet(const std::vector<Literal> &init_literals, SetType type) : LiteralSet(type)
+  {
+    for (const auto &l : init_literals)
+    {
+      add_literal(l);
+    }
+  }
+
+  void LiteralSet::recompute_hash()
+  {
+    std::size_t num_words = FactIndex::get_num_words();
+    positive_hash = 0;
+    negative_hash = 0;
+    for (std::size_t w = 0; w < num_words; w++)
+    {
+      positive_hash ^= get_word_hash(bits[w], w);
+      negative_hash ^= get_word_hash(bits[num_words + w], w);
+    }
   }
 
   bool LiteralSet::operator==(const LiteralSet &s) const
   {
     if (set_type == s.set_type)
     {
-      return literals == s.literals;
+      return num_literals == s.num_literals && positive_hash == s.positive_hash &&
+             negative_hash == s.negative_hash && bits == s.bits;
     }
     return false;
   }
@@ -133,7 +314,7 @@ namespace pdr_search
   {
     os << COLOR_RED "{";
     bool first = true;
-    for (const auto &c : ls.literals)
+    for (const auto &c : ls)
     {
       if (!first && ls.set_type == SetType::CUBE)
       {
@@ -150,10 +331,16 @@ namespace pdr_search
     return os;
   }
 
-  const std::unordered_set<Literal, LiteralHash> &LiteralSet::get_literals() const
+  LiteralSet::const_iterator LiteralSet::begin() const
   {
-    return literals;
+    return const_iterator(this, 0);
   }
+
+  LiteralSet::const_iterator LiteralSet::end() const
+  {
+    return const_iterator(this, bits.size());
+  }
+
   SetType LiteralSet::get_set_type() const
   {
     return set_type;
@@ -161,11 +348,6 @@ namespace pdr_search
 
   LiteralSet LiteralSet::invert() const
   {
-    std::unordered_set<Literal, LiteralHash> new_set;
-    for (const auto &l : literals)
-    {
-      new_set.insert(l.invert());
-    }
     SetType type;
     if (set_type == SetType::CLAUSE)
     {
@@ -175,27 +357,41 @@ namespace pdr_search
     {
       type = SetType::CLAUSE;
     }
-    return LiteralSet(new_set, type);
+    // swap the positive and the negative half of the bitmap
+    LiteralSet inverted = LiteralSet(type);
+    std::size_t num_words = FactIndex::get_num_words();
+    for (std::size_t w = 0; w < num_words; w++)
+    {
+      inverted.bits[w] = bits[num_words + w];
+      inverted.bits[num_words + w] = bits[w];
+    }
+    inverted.num_literals = num_literals;
+    inverted.positive_hash = negative_hash;
+    inverted.negative_hash = positive_hash;
+    return inverted;
   }
 
   LiteralSet LiteralSet::pos() const
   {
-    std::unordered_set<Literal,LiteralHash> new_set;
-    for (const auto &l : literals)
+    LiteralSet positive = LiteralSet(set_type);
+    std::size_t num_words = FactIndex::get_num_words();
+    for (std::size_t w = 0; w < num_words; w++)
     {
-      new_set.insert(l.pos());
+      positive.bits[w] = bits[w] | bits[num_words + w];
+      positive.num_literals += count_ones(positive.bits[w]);
     }
-    return LiteralSet(new_set, set_type);
+    positive.recompute_hash();
+    return positive;
   }
 
   size_t LiteralSet::size() const
   {
-    return literals.size();
+    return num_literals;
   }
 
   bool LiteralSet::is_unit() const
   {
-    return literals.size() == 1;
+    return num_literals == 1;
   }
 
   bool LiteralSet::is_clause() const
@@ -211,12 +407,28 @@ namespace pdr_search
   void LiteralSet::add_literal(Literal l)
   {
     assert(!contains_literal(l.invert()));
-    literals.insert(literals.begin(), l);
+    int index = l.get_fact_index();
+    uint64_t &word = bits[(l.is_positive() ? 0 : FactIndex::get_num_words()) + index / 64];
+    uint64_t mask = uint64_t(1) << (index % 64);
+    if (!(word & mask))
+    {
+      word |= mask;
+      num_literals += 1;
+      (l.is_positive() ? positive_hash : negative_hash) ^= get_fact_key(index);
+    }
   }
 
   void LiteralSet::remove_literal(Literal l)
   {
-    literals.erase(l);
+    int index = l.get_fact_index();
+    uint64_t &word = bits[(l.is_positive() ? 0 : FactIndex::get_num_words()) + index / 64];
+    uint64_t mask = uint64_t(1) << (index % 64);
+    if (word & mask)
+    {
+      word &= ~mask;
+      num_literals -= 1;
+      (l.is_positive() ? positive_hash : negative_hash) ^= get_fact_key(index);
+    }
   }
 
   void LiteralSet::apply_literal(const Literal &l)
@@ -228,15 +440,27 @@ namespace pdr_search
   void LiteralSet::apply_cube(const LiteralSet &l)
   {
     assert(l.is_cube());
-    for (const auto &lit : l.literals)
+    std::size_t num_words = FactIndex::get_num_words();
+    num_literals = 0;
+    for (std::size_t w = 0; w < num_words; w++)
     {
-      apply_literal(lit);
+      // remove ¬l for every literal l of the cube, then add l
+      uint64_t pos = (bits[w] & ~l.bits[num_words + w]) | l.bits[w];
+      uint64_t neg = (bits[num_words + w] & ~l.bits[w]) | l.bits[num_words + w];
+      // only the changed literals update the hash
+      positive_hash ^= get_word_hash(bits[w] ^ pos, w);
+      negative_hash ^= get_word_hash(bits[num_words + w] ^ neg, w);
+      bits[w] = pos;
+      bits[num_words + w] = neg;
+      num_literals += count_ones(pos) + count_ones(neg);
     }
   }
 
   bool LiteralSet::contains_literal(const Literal &l) const
   {
-    return literals.count(l) > 0;
+    int index = l.get_fact_index();
+    uint64_t word = bits[(l.is_positive() ? 0 : FactIndex::get_num_words()) + index / 64];
+    return (word >> (index % 64)) & 1;
   }
 
   bool LiteralSet::is_subset_eq_of(const LiteralSet &ls) const
@@ -245,9 +469,9 @@ namespace pdr_search
     {
       return false;
     }
-    for (const Literal &l : literals)
+    for (std::size_t w = 0; w < bits.size(); w++)
     {
-      if (!ls.contains_literal(l))
+      if (bits[w] & ~ls.bits[w])
       {
         return false;
       }
@@ -255,14 +479,49 @@ namespace pdr_search
     return true;
   }
 
+  bool LiteralSet::misses_one_literal_of(const LiteralSet &ls, Literal &missing) const
+  {
+    std::size_t num_missing = 0;
+    std::size_t num_words = FactIndex::get_num_words();
+    for (std::size_t w = 0; w < bits.size(); w++)
+    {
+      uint64_t word = bits[w] & ~ls.bits[w];
+      if (word == 0)
+      {
+        continue;
+      }
+      num_missing += count_ones(word);
+      if (num_missing > 1)
+      {
+        return false;
+      }
+      bool positive = w < num_words;
+      const FactPair &fact = FactIndex::get_fact((positive ? w : w - num_words) * 64 + count_trailing_zeros(word));
+      missing = Literal(fact.var, fact.value, positive);
+    }
+    return num_missing == 1;
+  }
+
+  uint64_t LiteralSet::get_signature() const
+  {
+    uint64_t signature = 0;
+    for (uint64_t word : bits)
+    {
+      signature |= word;
+    }
+    return signature;
+  }
+
   LiteralSet LiteralSet::set_union(const LiteralSet &s) const
   {
     assert(set_type == s.set_type);
-    LiteralSet tmp = LiteralSet(literals, set_type);
-    for (const auto &l : s.literals)
+    LiteralSet tmp = LiteralSet(set_type);
+    for (std::size_t w = 0; w < bits.size(); w++)
     {
-      tmp.add_literal(l);
+      tmp.bits[w] = bits[w] | s.bits[w];
+      tmp.num_literals += count_ones(tmp.bits[w]);
     }
+    tmp.recompute_hash();
 
     assert(is_subset_eq_of(tmp));
     assert(s.is_subset_eq_of(tmp));
@@ -273,35 +532,22 @@ namespace pdr_search
   {
     assert(set_type == s.set_type);
     size_t count = 0;
-
-    const LiteralSet *small = this, *big = &s;
-    if (this->size() >= s.size())
-    {
-      small = &s;
-      big = this;
-    }
-    for (const auto &l : big->literals)
+    for (std::size_t w = 0; w < bits.size(); w++)
     {
-      if (small->contains_literal(l))
-      {
-        count += 1; 
-      }
+      count += count_ones(bits[w] & s.bits[w]);
     }
-
     return count;
   }
 
   LiteralSet LiteralSet::set_minus(const LiteralSet &s) const
   {
-    std::unordered_set<Literal,LiteralHash> nliterals;
-    for (const auto &l : literals)
+    LiteralSet output = LiteralSet(set_type);
+    for (std::size_t w = 0; w < bits.size(); w++)
     {
-      if (!s.contains_literal(l))
-      {
-        nliterals.insert(l);
-      }
+      output.bits[w] = bits[w] & ~s.bits[w];
+      output.num_literals += count_ones(output.bits[w]);
     }
-    auto output = LiteralSet(nliterals, set_type);
+    output.recompute_hash();
     assert(output.is_subset_eq_of(*this));
     return output;
   }
@@ -312,9 +558,9 @@ namespace pdr_search
     if (c.is_clause())
     {
       // rhs must contain at least one literal from the lhs
-      for (const auto &cl : c.literals)
+      for (std::size_t w = 0; w < bits.size(); w++)
       {
-        if (contains_literal(cl))
+        if (bits[w] & c.bits[w])
         {
           return true;
         }
@@ -330,152 +576,547 @@ namespace pdr_search
 
   bool LiteralSet::models(const Layer &l) const
   {
-    const Layer *layer = &l;
-    while (layer != nullptr)
+    for (const auto &c : l)
     {
-        auto delta = layer->get_delta();
-        for (const auto &c : *delta)
-        {
-          if (!models(c))
-          {
-            return false;
-          }
-        }
-        layer = layer->get_child().get();
+      if (!models(c))
+      {
+        return false;
+      }
     }
     return true;
   }
 
-  std::size_t LiteralSet::hash() const
+  bool LiteralSet::is_consistent_with(const LiteralSet &ls) const
   {
-    utils::HashState hs;
-    utils::feed(hs, this->set_type);
-    utils::feed(hs, this->literals.size());
-
-    // ordering independent hash function
-    size_t literal_hash = 0;
-    for (const auto &s: this->literals) {
-        literal_hash ^= s.hash();
+    std::size_t num_words = FactIndex::get_num_words();
+    for (std::size_t w = 0; w < num_words; w++)
+    {
+      if ((bits[w] & ls.bits[num_words + w]) || (bits[num_words + w] & ls.bits[w]))
+      {
+        return false;
+      }
     }
-
-    utils::feed(hs, literal_hash);
-    return hs.get_hash64();
+    return true;
   }
 
-  std::size_t LiteralSetHash::operator () (LiteralSet const &v) const
+  bool LiteralSet::may_model(const LiteralSet &c) const
   {
-    return v.hash();
+    assert(is_cube());
+    assert(c.is_clause());
+    std::size_t num_words = FactIndex::get_num_words();
+    for (std::size_t w = 0; w < num_words; w++)
+    {
+      if ((c.bits[w] & ~bits[num_words + w]) || (c.bits[num_words + w] & ~bits[w]))
+      {
+        return true;
+      }
+    }
+    return false;
   }
 
-  Obligation::Obligation(const LiteralSet &s, int p, std::shared_ptr<Obligation> par) : parent(par), state(s), priority(p)
+  bool LiteralSet::may_model(const Layer &l) const
   {
-    assert(s.is_cube());
+    for (const auto &c : l)
+    {
+      if (!may_model(c))
+      {
+        return false;
+      }
+    }
+    return true;
   }
-  Obligation::Obligation(const Obligation &o) : state(o.state), priority(o.priority)
+
+  ClauseStatus LiteralSet::get_clause_status(const LiteralSet &c, Literal &unit) const
   {
+    assert(is_cube());
+    assert(c.is_clause());
+    for (std::size_t w = 0; w < bits.size(); w++)
+    {
+      if (c.bits[w] & bits[w])
+      {
+        return ClauseStatus::SATISFIED;
+      }
+    }
+    std::size_t num_words = FactIndex::get_num_words();
+    std::size_t num_open = 0;
+    for (std::size_t w = 0; w < 2 * num_words; w++)
+    {
+      // literals of c whose fact is not fixed to the other polarity
+      std::size_t other = w < num_words ? num_words + w : w - num_words;
+      uint64_t open = c.bits[w] & ~bits[other];
+      if (open == 0)
+      {
+        continue;
+      }
+      num_open += count_ones(open);
+      if (num_open > 1)
+      {
+        return ClauseStatus::OPEN;
+      }
+      bool positive = w < num_words;
+      const FactPair &fact = FactIndex::get_fact((positive ? w : other) * 64 + count_trailing_zeros(open));
+      unit = Literal(fact.var, fact.value, positive);
+    }
+    return num_open == 0 ? ClauseStatus::CONFLICT : ClauseStatus::UNIT;
   }
-  Obligation &Obligation::operator=(const Obligation &o)
+
+  std::size_t LiteralSet::hash() const
   {
-    priority = o.priority;
-    state = o.state;
-    return *this;
+    utils::HashState hs;
+    utils::feed(hs, this->set_type);
+    utils::feed(hs, positive_hash);
+    utils::feed(hs, negative_hash);
+    return hs.get_hash64();
   }
-  std::ostream &operator<<(std::ostream &os, const Obligation &o)
+
+  std::size_t LiteralSetHash::operator () (LiteralSet const &v) const
   {
-    os << "Ob(" << o.state << "," << o.priority << ")";
-    return os;
+    return v.hash();
   }
 
-  int Obligation::get_priority() const
+  FullState::FullState(const std::vector<int> &v) : values(v), facts(FactIndex::get_num_words(), 0)
   {
-    return priority;
+    for (std::size_t var = 0; var < values.size(); var++)
+    {
+      set_fact(var, values[var], true);
+    }
   }
 
-  LiteralSet Obligation::get_state() const
+  void FullState::set_fact(int variable, int value, bool state)
   {
-    return state;
+    int index = FactIndex::get_index(variable, value);
+    uint64_t mask = uint64_t(1) << (index % 64);
+    if (state)
+    {
+      facts[index / 64] |= mask;
+    }
+    else
+    {
+      facts[index / 64] &= ~mask;
+    }
   }
 
-  bool Obligation::operator<(const Obligation &o) const
+  bool FullState::operator==(const FullState &s) const
   {
-    // We want an inverted priority queue. Smallest first
-    return priority > o.priority;
+    return values == s.values;
   }
 
-  const std::shared_ptr<Obligation> Obligation::get_parent() const
+  bool FullState::operator!=(const FullState &s) const
   {
-    return parent;
+    return !(*this == s);
   }
 
-  SetOfLiteralSets::SetOfLiteralSets() : set_type(SetType::CUBE)
+  std::ostream &operator<<(std::ostream &os, const FullState &s)
   {
+    return os << s.to_cube();
   }
-  SetOfLiteralSets::SetOfLiteralSets(SetType type) : set_type(type)
+
+  int FullState::operator[](int variable) const
   {
+    return values[variable];
   }
-  SetOfLiteralSets::SetOfLiteralSets(const SetOfLiteralSets &s) : set_type(s.set_type), sets(s.sets)
+
+  std::size_t FullState::size() const
   {
+    return values.size();
   }
-  SetOfLiteralSets::SetOfLiteralSets(const std::unordered_set<LiteralSet, LiteralSetHash> &s, SetType type) : set_type(type), sets(s)
+
+  void FullState::apply_cube(const LiteralSet &c)
   {
-    for (const auto &set : s)
+    assert(c.is_cube());
+    for (const auto &l : c)
     {
-      assert(set.get_set_type() == type);
+      if (l.is_positive())
+      {
+        set_fact(l.get_variable(), values[l.get_variable()], false);
+        values[l.get_variable()] = l.get_value();
+        set_fact(l.get_variable(), l.get_value(), true);
+      }
     }
   }
-  SetOfLiteralSets::~SetOfLiteralSets()
-  {
-  }
-  SetOfLiteralSets &SetOfLiteralSets::operator=(const SetOfLiteralSets &s)
-  {
-    set_type = s.set_type;
-    sets = s.sets;
-    return *this;
-  }
 
-  bool SetOfLiteralSets::operator==(const SetOfLiteralSets &s) const
+  bool FullState::models(const Literal &l) const
   {
-    return set_type == s.set_type && sets == s.sets;
+    return (values[l.get_variable()] == l.get_value()) == l.is_positive();
   }
 
-  std::ostream &operator<<(std::ostream &os, const SetOfLiteralSets &s)
+  bool FullState::models(const LiteralSet &ls) const
   {
-    os << COLOR_CYAN "Set{";
-    bool first = true;
-    for (const auto &c : s.get_sets())
+    std::size_t num_words = facts.size();
+    if (ls.is_clause())
     {
-      if (first)
+      // some positive literal is a true fact or some negative literal is a false fact
+      for (std::size_t w = 0; w < num_words; w++)
       {
-        first = false;
+        if ((ls.bits[w] & facts[w]) || (ls.bits[num_words + w] & ~facts[w]))
+        {
+          return true;
+        }
       }
-      else
+      return false;
+    }
+    else
+    {
+      // all positive literals are true facts and all negative literals are false facts
+      for (std::size_t w = 0; w < num_words; w++)
       {
-        os << COLOR_CYAN ", ";
+        if ((ls.bits[w] & ~facts[w]) || (ls.bits[num_words + w] & facts[w]))
+        {
+          return false;
+        }
       }
-      os << c;
+      return true;
     }
-    os << COLOR_CYAN "}" COLOR_NONE;
-    return os;
   }
-  size_t SetOfLiteralSets::size() const
+
+  bool FullState::models(const Layer &l) const
   {
-    return sets.size();
+    for (const auto &c : l)
+    {
+      if (!models(c))
+      {
+        return false;
+      }
+    }
+    return true;
   }
 
-  const std::unordered_set<LiteralSet, LiteralSetHash> SetOfLiteralSets::get_sets() const
+  LiteralSet FullState::to_cube() const
   {
-    return sets;
+    LiteralSet c = LiteralSet(SetType::CUBE);
+    for (std::size_t var = 0; var < values.size(); var++)
+    {
+      int dom_size = FactIndex::get_domain_size(var);
+      for (int i = 0; i < dom_size; i++)
+      {
+        c.add_literal(Literal(var, i, i == values[var]));
+      }
+    }
+    return c;
   }
 
-  void SetOfLiteralSets::add_set(const LiteralSet &c)
+  std::size_t FullState::hash() const
   {
-    assert(c.get_set_type() == set_type);
-    this->sets.insert(c);
+    utils::HashState hs;
+    utils::feed(hs, values);
+    return hs.get_hash64();
   }
 
-  bool SetOfLiteralSets::contains_set(const LiteralSet &c) const
+  const int Obligation::NO_PARENT;
+
+  Obligation::Obligation(FullState s, int p, int par) : state(std::move(s)), priority(p), parent(par)
   {
-    auto res = this->sets.count(c);
+  }
+  std::ostream &operator<<(std::ostream &os, const Obligation &o)
+  {
+    os << "Ob(" << o.state << "," << o.priority << ")";
+    return os;
+  }
+
+  int Obligation::get_priority() const
+  {
+    return priority;
+  }
+
+  void Obligation::set_priority(int p)
+  {
+    priority = p;
+  }
+
+  const FullState &Obligation::get_state() const
+  {
+    return state;
+  }
+
+  bool Obligation::operator<(const Obligation &o) const
+  {
+    // We want an inverted priority queue. Smallest first
+    return priority > o.priority;
+  }
+
+  int Obligation::get_parent() const
+  {
+    return parent;
+  }
+
+  ObligationManager::ObligationManager(ObligationTieBreaking t) : tie_breaking(t), min_bucket(0), num_queued(0)
+  {
+  }
+
+  int ObligationManager::create(FullState s, int priority, int parent)
+  {
+    assert(priority >= 0);
+    assert(parent == Obligation::NO_PARENT || parent < static_cast<int>(obligations.size()));
+    obligations.push_back(Obligation(std::move(s), priority, parent));
+    return obligations.size() - 1;
+  }
+
+  const Obligation &ObligationManager::get(int ob) const
+  {
+    return obligations[ob];
+  }
+
+  void ObligationManager::set_priority(int ob, int priority)
+  {
+    assert(priority >= 0);
+    obligations[ob].set_priority(priority);
+  }
+
+  void ObligationManager::push(int ob)
+  {
+    std::size_t priority = obligations[ob].get_priority();
+    if (priority >= buckets.size())
+    {
+      buckets.resize(priority + 1);
+    }
+    buckets[priority].push_back(ob);
+    if (num_queued == 0 || priority < min_bucket)
+    {
+      min_bucket = priority;
+    }
+    num_queued += 1;
+  }
+
+  int ObligationManager::pop()
+  {
+    assert(!empty());
+    while (buckets[min_bucket].empty())
+    {
+      min_bucket += 1;
+    }
+    std::deque<int> &bucket = buckets[min_bucket];
+    int ob;
+    if (tie_breaking == ObligationTieBreaking::LIFO)
+    {
+      ob = bucket.back();
+      bucket.pop_back();
+    }
+    else
+    {
+      ob = bucket.front();
+      bucket.pop_front();
+    }
+    num_queued -= 1;
+    return ob;
+  }
+
+  int ObligationManager::get_min_priority() const
+  {
+    assert(!empty());
+    std::size_t priority = min_bucket;
+    while (buckets[priority].empty())
+    {
+      priority += 1;
+    }
+    return priority;
+  }
+
+  std::vector<int> ObligationManager::peek(std::size_t n) const
+  {
+    std::vector<int> obs;
+    if (empty())
+    {
+      return obs;
+    }
+    const std::deque<int> &bucket = buckets[get_min_priority()];
+    n = std::min(n, bucket.size());
+    for (std::size_t i = 0; i < n; i++)
+    {
+      if (tie_breaking == ObligationTieBreaking::LIFO)
+      {
+        obs.push_back(bucket[bucket.size() - 1 - i]);
+      }
+      else
+      {
+        obs.push_back(bucket[i]);
+      }
+    }
+    return obs;
+  }
+
+  bool ObligationManager::empty() const
+  {
+    return num_queued == 0;
+  }
+
+  std::size_t ObligationManager::size() const
+  {
+    return obligations.size();
+  }
+
+  void ObligationManager::clear()
+  {
+    obligations.clear();
+    for (auto &bucket : buckets)
+    {
+      bucket.clear();
+    }
+    min_bucket = 0;
+    num_queued = 0;
+  }
+
+  std::vector<int> ObligationManager::keep(const std::vector<int> &obs)
+  {
+    std::vector<bool> kept(obligations.size(), false);
+    for (int ob : obs)
+    {
+      kept[ob] = true;
+    }
+    // parents are created before their children
+    for (std::size_t ob = obligations.size(); ob-- > 0;)
+    {
+      int parent = obligations[ob].get_parent();
+      if (kept[ob] && parent != Obligation::NO_PARENT)
+      {
+        kept[parent] = true;
+      }
+    }
+
+    std::vector<int> new_index(obligations.size(), Obligation::NO_PARENT);
+    std::vector<Obligation> remaining;
+    for (std::size_t ob = 0; ob < obligations.size(); ob++)
+    {
+      if (!kept[ob])
+      {
+        continue;
+      }
+      const Obligation &o = obligations[ob];
+      int parent = o.get_parent();
+      if (parent != Obligation::NO_PARENT)
+      {
+        parent = new_index[parent];
+      }
+      new_index[ob] = remaining.size();
+      remaining.push_back(Obligation(o.get_state(), o.get_priority(), parent));
+    }
+    clear();
+    obligations.swap(remaining);
+
+    std::vector<int> kept_obs;
+    for (int ob : obs)
+    {
+      kept_obs.push_back(new_index[ob]);
+    }
+    return kept_obs;
+  }
+
+  BlockedStateCache::BlockedStateCache(const int_packer::IntPacker &p) : packer(p)
+  {
+  }
+
+  std::vector<int_packer::IntPacker::Bin> pack_state(const int_packer::IntPacker &packer, const FullState &s)
+  {
+    std::vector<int_packer::IntPacker::Bin> buffer(packer.get_num_bins(), 0);
+    for (std::size_t var = 0; var < s.size(); var++)
+    {
+      packer.set(buffer.data(), var, s[var]);
+    }
+    return buffer;
+  }
+
+  void BlockedStateCache::set_blocked(const FullState &s, int layer)
+  {
+    auto inserted = blocked.insert(std::make_pair(pack_state(packer, s), layer));
+    if (!inserted.second && inserted.first->second < layer)
+    {
+      inserted.first->second = layer;
+    }
+  }
+
+  int BlockedStateCache::get_blocked_layer(const FullState &s) const
+  {
+    auto it = blocked.find(pack_state(packer, s));
+    if (it == blocked.end())
+    {
+      return -1;
+    }
+    return it->second;
+  }
+
+  std::size_t BlockedStateCache::size() const
+  {
+    return blocked.size();
+  }
+
+  void BlockedStateCache::clear()
+  {
+    utils::HashMap<std::vector<int_packer::IntPacker::Bin>, int>().swap(blocked);
+  }
+
+  SetOfLiteralSets::SetOfLiteralSets() : set_type(SetType::CUBE), sets_hash(0)
+  {
+  }
+  SetOfLiteralSets::SetOfLiteralSets(SetType type) : set_type(type), sets_hash(0)
+  {
+  }
+  SetOfLiteralSets::SetOfLiteralSets(const SetOfLiteralSets &s) : set_type(s.set_type), sets(s.sets), sets_hash(s.sets_hash)
+  {
+  }
+  SetOfLiteralSets::SetOfLiteralSets(const std::unordered_set<LiteralSet, LiteralSetHash> &s, SetType type) : set_type(type), sets(s), sets_hash(0)
+  {
+    for (const auto &set : s)
+    {
+      assert(set.get_set_type() == type);
+      sets_hash ^= set.hash();
+    }
+  }
+  SetOfLiteralSets::~SetOfLiteralSets()
+  {
+  }
+  SetOfLiteralSets &SetOfLiteralSets::operator=(const SetOfLiteralSets &s)
+  {
+    set_type = s.set_type;
+    sets = s.sets;
+    sets_hash = s.sets_hash;
+    return *this;
+  }
+
+  bool SetOfLiteralSets::operator==(const SetOfLiteralSets &s) const
+  {
+    return set_type == s.set_type && sets_hash == s.sets_hash && sets == s.sets;
+  }
+
+  std::ostream &operator<<(std::ostream &os, const SetOfLiteralSets &s)
+  {
+    os << COLOR_CYAN "Set{";
+    bool first = true;
+    for (const auto &c : s.get_sets())
+    {
+      if (first)
+      {
+        first = false;
+      }
+      else
+      {
+        os << COLOR_CYAN ", ";
+      }
+      os << c;
+    }
+    os << COLOR_CYAN "}" COLOR_NONE;
+    return os;
+  }
+  size_t SetOfLiteralSets::size() const
+  {
+    return sets.size();
+  }
+
+  const std::unordered_set<LiteralSet, LiteralSetHash> &SetOfLiteralSets::get_sets() const
+  {
+    return sets;
+  }
+
+  void SetOfLiteralSets::add_set(const LiteralSet &c)
+  {
+    assert(c.get_set_type() == set_type);
+    if (this->sets.insert(c).second)
+    {
+      sets_hash ^= c.hash();
+    }
+  }
+
+  bool SetOfLiteralSets::contains_set(const LiteralSet &c) const
+  {
+    auto res = this->sets.count(c);
     return res > 0;
   }
 
@@ -520,14 +1161,8 @@ namespace pdr_search
     utils::HashState hs;
     utils::feed(hs, this->set_type);
     utils::feed(hs, this->sets.size());
-
     // ordering independent hash function
-    size_t literal_hash = 0;
-    for (const auto &s: this->sets) {
-        literal_hash ^= s.hash();
-    }
-
-    utils::feed(hs, literal_hash);
+    utils::feed(hs, sets_hash);
     return hs.get_hash64();
   }
 
@@ -536,25 +1171,331 @@ namespace pdr_search
      return v.hash(); 
   }
 
+  LayerDelta::const_iterator::const_iterator(const std::vector<const LiteralSet *> *l, std::size_t i, std::size_t e) :
+      log(l),
+      index(i),
+      end_index(e)
+  {
+    skip_tombstones();
+  }
+
+  void LayerDelta::const_iterator::skip_tombstones()
+  {
+    while (index < end_index && (*log)[index] == nullptr) {
+        index += 1;
+    }
+  }
+
+  const LiteralSet &LayerDelta::const_iterator::operator*() const
+  {
+    return *(*log)[index];
+  }
+
+  const LiteralSet *LayerDelta::const_iterator::operator->() const
+  {
+    return (*log)[index];
+  }
+
+  LayerDelta::const_iterator &LayerDelta::const_iterator::operator++()
+  {
+    index += 1;
+    skip_tombstones();
+    return *this;
+  }
+
+  bool LayerDelta::const_iterator::operator==(const const_iterator &it) const
+  {
+    return log == it.log && index == it.index;
+  }
+
+  bool LayerDelta::const_iterator::operator!=(const const_iterator &it) const
+  {
+    return !(*this == it);
+  }
+
+  LayerDelta::LayerDelta() :
+      num_tombstones(0),
+      active_snapshots(0),
+      occurrences(FactIndex::get_num_variables())
+  {
+  }
+
+  LayerDelta::LayerDelta(const LayerDelta &d) :
+      num_tombstones(0),
+      active_snapshots(0),
+      occurrences(FactIndex::get_num_variables())
+  {
+    for (const auto &c : d)
+    {
+      insert(c);
+    }
+  }
+
+  const LiteralSet *LayerDelta::insert(const LiteralSet &c)
+  {
+    return insert(c, next_stamp++);
+  }
+
+  const LiteralSet *LayerDelta::insert(const LiteralSet &c, std::size_t stamp, double activity)
+  {
+    auto inserted = positions.insert(std::make_pair(c, log.size()));
+    if (!inserted.second) {
+        return nullptr;
+    }
+    const LiteralSet *stored = &inserted.first->first;
+    add_occurrences(stored, log.size());
+    log.push_back(stored);
+    stamps.push_back(stamp);
+    signatures.push_back(stored->get_signature());
+    activities.push_back(activity);
+    return stored;
+  }
+
+  bool LayerDelta::erase(const LiteralSet &c)
+  {
+    auto it = positions.find(c);
+    if (it == positions.end()) {
+        return false;
+    }
+    log[it->second] = nullptr;
+    num_tombstones += 1;
+    positions.erase(it);
+    if (active_snapshots == 0 && num_tombstones > log.size() / 2) {
+        compact();
+    }
+    return true;
+  }
+
+  void LayerDelta::compact()
+  {
+    assert(active_snapshots == 0);
+    for (auto &occ : occurrences) {
+        occ.clear();
+    }
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < log.size(); i++) {
+        if (log[i] != nullptr) {
+            positions[*log[i]] = next;
+            log[next] = log[i];
+            stamps[next] = stamps[i];
+            signatures[next] = signatures[i];
+            activities[next] = activities[i];
+            add_occurrences(log[next], next);
+            next += 1;
+        }
+    }
+    log.resize(next);
+    stamps.resize(next);
+    signatures.resize(next);
+    activities.resize(next);
+    num_tombstones = 0;
+  }
+
+  bool LayerDelta::contains(const LiteralSet &c) const
+  {
+    return positions.count(c) > 0;
+  }
+
+  std::size_t LayerDelta::size() const
+  {
+    return positions.size();
+  }
+
+  bool LayerDelta::empty() const
+  {
+    return positions.empty();
+  }
+
+  LayerDelta::const_iterator LayerDelta::begin() const
+  {
+    return const_iterator(&log, 0, log.size());
+  }
+
+  LayerDelta::const_iterator LayerDelta::end() const
+  {
+    return const_iterator(&log, log.size(), log.size());
+  }
+
+  void LayerDelta::add_occurrences(const LiteralSet *c, std::size_t position)
+  {
+    for (const auto &l : *c) {
+        auto &occ = occurrences[l.get_variable()];
+        // a clause can contain several literals over the same variable
+        if (occ.empty() || occ.back() != position) {
+            occ.push_back(position);
+        }
+    }
+  }
+
+  const std::vector<std::size_t> &LayerDelta::get_occurrences(int variable) const
+  {
+      return this->occurrences[variable];
+  }
+
+  const LiteralSet *LayerDelta::get_clause(std::size_t position) const
+  {
+      return this->log[position];
+  }
+
+  std::size_t LayerDelta::get_num_positions() const
+  {
+      return this->log.size();
+  }
+
+  std::size_t LayerDelta::get_stamp(std::size_t position) const
+  {
+      return this->stamps[position];
+  }
+
+  uint64_t LayerDelta::get_signature(std::size_t position) const
+  {
+      return this->signatures[position];
+  }
+
+  std::size_t LayerDelta::get_stamp(const LiteralSet &c) const
+  {
+      return this->stamps[this->positions.at(c)];
+  }
+
+  std::size_t LayerDelta::get_next_stamp()
+  {
+      return next_stamp;
+  }
+
+  double LayerDelta::get_activity(std::size_t position) const
+  {
+      return this->activities[position];
+  }
+
+  double LayerDelta::get_activity(const LiteralSet &c) const
+  {
+      return this->activities[this->positions.at(c)];
+  }
+
+  bool LayerDelta::bump_activity(const LiteralSet &c, double amount) const
+  {
+      auto it = this->positions.find(c);
+      if (it == this->positions.end()) {
+          return false;
+      }
+      this->activities[it->second] += amount;
+      return true;
+  }
+
+  void LayerDelta::scale_activities(double factor) const
+  {
+      for (double &activity : this->activities) {
+          activity *= factor;
+      }
+  }
+
+  std::size_t LayerDelta::get_clause_memory(const LiteralSet &c)
+  {
+      // at most one occurrence per literal
+      return get_stored_clause_memory() + get_position_memory() + c.size() * sizeof(std::size_t);
+  }
+
+  std::size_t LayerDelta::get_memory_usage() const
+  {
+      std::size_t usage = this->positions.size() * get_stored_clause_memory() +
+          this->positions.bucket_count() * sizeof(void *) +
+          this->log.capacity() * get_position_memory();
+      for (const auto &occ : this->occurrences) {
+          usage += occ.capacity() * sizeof(std::size_t);
+      }
+      return usage;
+  }
+
+  DeltaSnapshot::DeltaSnapshot(const LayerDelta &d) : delta(d), end_index(d.log.size())
+  {
+    delta.active_snapshots += 1;
+  }
+
+  DeltaSnapshot::~DeltaSnapshot()
+  {
+    delta.active_snapshots -= 1;
+  }
+
+  LayerDelta::const_iterator DeltaSnapshot::begin() const
+  {
+    return LayerDelta::const_iterator(&delta.log, 0, end_index);
+  }
+
+  LayerDelta::const_iterator DeltaSnapshot::end() const
+  {
+    return LayerDelta::const_iterator(&delta.log, end_index, end_index);
+  }
+
+  Layer::const_iterator::const_iterator(const Layer *l) :
+      layer(l),
+      it(nullptr, 0, 0)
+  {
+    if (layer != nullptr) {
+        it = layer->delta->begin();
+        skip_empty_deltas();
+    }
+  }
+
+  void Layer::const_iterator::skip_empty_deltas()
+  {
+    while (layer != nullptr && it == layer->delta->end()) {
+        layer = layer->child.get();
+        it = (layer != nullptr) ? layer->delta->begin() : LayerDelta::const_iterator(nullptr, 0, 0);
+    }
+  }
+
+  const LiteralSet &Layer::const_iterator::operator*() const
+  {
+    return *it;
+  }
+
+  const LiteralSet *Layer::const_iterator::operator->() const
+  {
+    return &*it;
+  }
+
+  Layer::const_iterator &Layer::const_iterator::operator++()
+  {
+    ++it;
+    skip_empty_deltas();
+    return *this;
+  }
+
+  bool Layer::const_iterator::operator==(const const_iterator &o) const
+  {
+    return layer == o.layer && it == o.it;
+  }
+
+  bool Layer::const_iterator::operator!=(const const_iterator &o) const
+  {
+    return !(*this == o);
+  }
+
   Layer::Layer(std::shared_ptr<Layer> c, std::shared_ptr<Layer> p) : 
       parent(p), 
       child(c), 
-      __sets(std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>>(new std::unordered_set<LiteralSet, LiteralSetHash>())) 
+      delta(std::make_shared<LayerDelta>()),
+      version(0),
+      // the clauses a new layer receives from its parent were simplified with it
+      simplified_stamp(p ? p->simplified_stamp : 0)
   {
   }
 
   Layer::Layer(const Layer &l) :  
-      child(l.child), 
       parent(l.parent), 
-      __sets(std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>>(new std::unordered_set<LiteralSet, LiteralSetHash>(*l.get_delta())))
+      child(l.child), 
+      delta(std::make_shared<LayerDelta>(*l.delta)),
+      version(l.version),
+      simplified_stamp(0)
   {
-      
   }
 
   Layer::Layer(const std::unordered_set<LiteralSet> &c,std::shared_ptr<Layer> ci, std::shared_ptr<Layer> p ):
       parent(p),
       child(ci), 
-      __sets(std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>>(new std::unordered_set<LiteralSet, LiteralSetHash>())) 
+      delta(std::make_shared<LayerDelta>()),
+      version(0),
+      simplified_stamp(0)
   {
     for (const LiteralSet &ls : c)
     {
@@ -565,9 +1506,11 @@ namespace pdr_search
 
   Layer &Layer::operator=(const Layer &l)
   {
-    __sets = l.__sets;
+    delta = l.delta;
     parent = l.parent;
     child = l.child;
+    version = l.version;
+    simplified_stamp = l.simplified_stamp;
     return *this;
   }
 
@@ -575,8 +1518,7 @@ namespace pdr_search
   {
     os << COLOR_CYAN "Layer{";
     bool first = true;
-    auto sets = *l.get_sets();
-    for (const auto &c : sets)
+    for (const auto &c : l)
     {
       if (first)
       {
@@ -597,27 +1539,15 @@ namespace pdr_search
       this->child = c;
   }
 
-  const std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> Layer::get_sets() const 
+  Layer::const_iterator Layer::begin() const
   {
-    std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> sets(new std::unordered_set<LiteralSet, LiteralSetHash>());
-    size_t total_size = 0;
-    // calculate size of set
-    const Layer *child = this;
-    while (child != nullptr) {
-        total_size += child->size();
-        child = child->child.get();
-    }
-    sets->reserve(total_size);
-
-    child = this;
-    while (child != nullptr) {
-        auto delta = child->get_delta();
-        sets->insert(delta->begin(), delta->end());
-        child = child->child.get();
-    }
-    return sets;
+    return const_iterator(this);
   }
 
+  Layer::const_iterator Layer::end() const
+  {
+    return const_iterator(nullptr);
+  }
 
   void Layer::print_stack() const 
   {
@@ -626,8 +1556,7 @@ namespace pdr_search
       }
       std::cout << " Layer "<< (this->parent?"(p)":"" )<<(this->child?"(c)":"");
       std::cout << "Layer delta: ";
-      auto delta = *child->get_delta();
-      for (const auto &s : delta) {
+      for (const auto &s : *this->delta) {
           std::cout << s << ", ";
       }
       std::cout << std::endl;
@@ -639,32 +1568,57 @@ namespace pdr_search
   {
     assert(c.is_clause());
     // don't insert if current or child layer already has the literalset
-    bool child_already_has_set = false;
-    Layer* child = this;
-    while (child != nullptr) {
-        auto sets = child->get_delta(); 
-        if (sets->count(c) > 0) {
-            child_already_has_set = true;
-            break;
-        }
-        child = child->child.get();
+    if (contains_set(c)) {
+        return;
+    }
+    // A clause is stored in at most one delta of the chain, so it has to
+    // be moved from the first parent that has it. The parents up to there
+    // did not contain the clause before.
+    std::shared_ptr<Layer> holder = this->parent;
+    while (holder != nullptr && !holder->delta->contains(c)) {
+        holder->version += 1;
+        holder = holder->parent;
     }
+    this->version += 1;
+    if (holder == nullptr) {
+        this->delta->insert(c);
+        return;
+    }
+    // c may refer to the clause stored in the parent delta,
+    // so only use the stored copy from here on.
+    const LiteralSet *stored = this->delta->insert(c, holder->delta->get_stamp(c), holder->delta->get_activity(c));
+    holder->delta->erase(*stored);
+  }
 
-    if (!child_already_has_set) {
-        this->__sets->insert(c);
-        // erase from all parent layers
-        std::shared_ptr<Layer> parent = this->parent;
-        while (parent != nullptr) {
-            parent->__sets->erase(c);
-            parent = parent->parent;
+  bool Layer::remove_set(const LiteralSet &c)
+  {
+    if (!this->delta->erase(c)) {
+        return false;
+    }
+    for (Layer *l = this; l != nullptr; l = l->parent.get()) {
+        l->version += 1;
+    }
+    return true;
+  }
+
+  void Layer::bump_activity(const LiteralSet &c, double amount) const
+  {
+    for (const Layer *l = this; l != nullptr; l = l->child.get()) {
+        if (l->delta->bump_activity(c, amount)) {
+            return;
         }
-    }        
+    }
+    assert(false);
   }
 
+  const LayerDelta &Layer::get_delta() const 
+  {
+      return *this->delta;
+  }
 
-  const std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> Layer::get_delta() const 
+  std::size_t Layer::get_version() const
   {
-      return this->__sets;
+      return this->version;
   }
   
   bool Layer::is_subset_eq_of(const Layer &s) const
@@ -673,8 +1627,7 @@ namespace pdr_search
     {
       return false;
     }
-    auto sets = this->get_sets();
-    for (const LiteralSet &c : *sets)
+    for (const LiteralSet &c : *this)
     {
       if (!s.contains_set(c))
       {
@@ -686,10 +1639,10 @@ namespace pdr_search
   
   size_t Layer::size() const 
   {
-      size_t sum = this->__sets->size();
+      size_t sum = this->delta->size();
       Layer *l = this->child.get();
       while (l != nullptr) {
-          sum += l->__sets->size();
+          sum += l->delta->size();
           l = l->child.get();
       }
       return sum;
@@ -700,8 +1653,7 @@ namespace pdr_search
   {
     const Layer* child = this;
     while (child != nullptr) {
-        auto sets = child->get_delta(); 
-        if (sets->count(c) > 0) {
+        if (child->delta->contains(c)) {
             return true;
         }
         child = child->child.get();
@@ -714,9 +1666,170 @@ namespace pdr_search
     return this->child;
   }
 
-  void Layer::simplify()
+  // Every layer that contains a clause of this delta also contains the
+  // clauses of this layer and its children. So a clause c of the delta
+  // that is subsumed by such a clause d ⊆ c can be removed from all these
+  // layers at once. If d = A ∨ l and c = A ∨ B ∨ ¬l, then c can be replaced
+  // by A ∨ B, which d and c imply.
+  // Only pairs with a clause that is new since the last call are checked.
+  // Clauses keep their stamp when they are pushed, so a pair can be missed
+  // if one of its clauses was pushed from a parent that was not simplified
+  // since, which only leaves the layer larger.
+  std::size_t Layer::simplify()
+  {
+    std::size_t since = this->simplified_stamp;
+    this->simplified_stamp = LayerDelta::get_next_stamp();
+    std::size_t num_simplified = 0;
+    // erase must not compact the delta while positions are in use
+    DeltaSnapshot snapshot(*this->delta);
+
+    // Clauses that were added since the last call may subsume old clauses.
+    for (const Layer *l = this; l != nullptr; l = l->child.get())
+    {
+      const LayerDelta &d_delta = *l->delta;
+      for (std::size_t position = 0; position < d_delta.get_num_positions(); position++)
+      {
+        const LiteralSet *d = d_delta.get_clause(position);
+        std::size_t stamp = d_delta.get_stamp(position);
+        if (d != nullptr && since <= stamp && stamp < this->simplified_stamp)
+        {
+          num_simplified += simplify_with(d);
+        }
+      }
+    }
+
+    // Clauses that were added since the last call may be subsumed by old
+    // clauses, pairs of new clauses were already checked above.
+    for (std::size_t position = 0; since > 0 && position < this->delta->get_num_positions(); position++)
+    {
+      const LiteralSet *c = this->delta->get_clause(position);
+      std::size_t stamp = this->delta->get_stamp(position);
+      if (c == nullptr || stamp < since || stamp >= this->simplified_stamp)
+      {
+        continue;
+      }
+      tl::optional<Literal> resolved;
+      if (!is_subsumed(c, since, resolved) && !resolved)
+      {
+        continue;
+      }
+      // erase destroys the stored clause
+      LiteralSet strengthened = *c;
+      this->delta->erase(strengthened);
+      num_simplified += 1;
+      if (resolved)
+      {
+        strengthened.remove_literal(*resolved);
+        add_set(strengthened);
+      }
+    }
+    return num_simplified;
+  }
+
+  std::size_t Layer::simplify_with(const LiteralSet *d)
+  {
+    // Every clause that d subsumes or that can be resolved with d contains
+    // a literal over every variable of d.
+    int variable = -1;
+    for (const auto &l : *d)
+    {
+      int v = l.get_variable();
+      if (variable == -1 || this->delta->get_occurrences(v).size() < this->delta->get_occurrences(variable).size())
+      {
+        variable = v;
+      }
+    }
+    if (variable == -1)
+    {
+      return 0;
+    }
+
+    std::size_t num_simplified = 0;
+    uint64_t signature = d->get_signature();
+    // add_set can append to the occurrences while iterating
+    const std::vector<std::size_t> &occurrences = this->delta->get_occurrences(variable);
+    std::size_t num_occurrences = occurrences.size();
+    for (std::size_t o = 0; o < num_occurrences; o++)
+    {
+      // c has to contain all literals of d but one
+      if (count_ones(signature & ~this->delta->get_signature(occurrences[o])) > 1)
+      {
+        continue;
+      }
+      const LiteralSet *c = this->delta->get_clause(occurrences[o]);
+      if (c == nullptr || c == d || c->size() < d->size())
+      {
+        continue;
+      }
+      tl::optional<Literal> resolved;
+      if (!d->is_subset_eq_of(*c))
+      {
+        Literal l = Literal(0, 0);
+        if (c->size() == 1 || !d->misses_one_literal_of(*c, l) || !c->contains_literal(l.invert()))
+        {
+          continue;
+        }
+        resolved = l.invert();
+      }
+      LiteralSet strengthened = *c;
+      this->delta->erase(strengthened);
+      num_simplified += 1;
+      if (resolved)
+      {
+        strengthened.remove_literal(*resolved);
+        add_set(strengthened);
+      }
+    }
+    return num_simplified;
+  }
+
+  bool Layer::is_subsumed(const LiteralSet *c, std::size_t since, tl::optional<Literal> &resolved) const
   {
-      // NOTE: Don't "simplify" the layers. 
-      // this could violate the layer invariants
+    std::vector<int> variables;
+    for (const auto &l : *c)
+    {
+      variables.push_back(l.get_variable());
+    }
+    std::sort(variables.begin(), variables.end());
+    variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+
+    uint64_t signature = c->get_signature();
+    // Every clause d ⊆ c contains a literal over a variable of c.
+    for (const Layer *l = this; l != nullptr; l = l->child.get())
+    {
+      // a clause occurs in the lists of all its variables
+      std::vector<bool> visited(l->delta->get_num_positions(), false);
+      for (int var : variables)
+      {
+        for (std::size_t position : l->delta->get_occurrences(var))
+        {
+          if (visited[position])
+          {
+            continue;
+          }
+          visited[position] = true;
+          if (count_ones(l->delta->get_signature(position) & ~signature) > 1)
+          {
+            continue;
+          }
+          const LiteralSet *d = l->delta->get_clause(position);
+          if (d == nullptr || d == c || d->size() > c->size() || l->delta->get_stamp(position) >= since)
+          {
+            continue;
+          }
+          if (d->is_subset_eq_of(*c))
+          {
+            return true;
+          }
+          Literal lit = Literal(0, 0);
+          if (!resolved && c->size() > 1 && d->misses_one_literal_of(*c, lit) && c->contains_literal(lit.invert()))
+          {
+            resolved = lit.invert();
+          }
+        }
+      }
+    }
+    return false;
   }
+
 }
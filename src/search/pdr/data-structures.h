@@ -1,14 +1,24 @@
 #ifndef PDR_DATA_STRUCTURES_H
 #define PDR_DATA_STRUCTURES_H
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <set>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <optional.hh>
 
 #include "../task_proxy.h"
+#include "../algorithms/int_packer.h"
+#include "../utils/hash.h"
 #include "constants.h"
 
 namespace pdr_search
@@ -21,28 +31,50 @@ namespace pdr_search
   class Literal;
   class LiteralHash;
   class LiteralSet;
+  class FullState;
   class Obligation;
   class SetOfLiteralSets;
   class Layer;
 
+  // Dense global numbering of all facts (variable/value pairs) of the
+  // planning task. Literal sets are stored as bitmaps over this numbering,
+  // so it has to be initialized before the first LiteralSet is created.
+  class FactIndex
+  {
+  private:
+    static const AbstractTask *task;
+    static std::vector<int> variable_offsets;
+    static std::vector<FactPair> facts;
+    static std::size_t num_words;
+
+  public:
+    static void initialize(const AbstractTask &task);
+    static std::size_t get_num_facts();
+    // Number of 64 bit words needed to store one bit per fact.
+    static std::size_t get_num_words();
+    static int get_num_variables();
+    static int get_index(int variable, int value);
+    static int get_domain_size(int variable);
+    static const FactPair &get_fact(int index);
+    static std::string get_name(int variable, int value);
+  };
+
   class Literal
   {
   private:
     int variable;
     int value;
     bool positive = true;
-    FactProxy fact;
-
-    mutable size_t hash_cache = 0;
 
   public:
-    Literal(int variable, int value, const FactProxy &fp);
-    Literal(int variable, int value, bool positive, const FactProxy &fp);
-    Literal(const Literal &l);
-    Literal &operator=(const Literal &l);
+    Literal(int variable, int value);
+    Literal(int variable, int value, bool positive);
     bool operator==(const Literal &l) const;
     bool operator<(const Literal &b) const;
     bool is_positive() const;
+    int get_variable() const;
+    int get_value() const;
+    int get_fact_index() const;
     friend std::ostream &operator<<(std::ostream &os, const Literal &l);
     Literal invert() const;
     Literal neg() const;
@@ -56,25 +88,71 @@ namespace pdr_search
     std::size_t operator () (Literal const &v) const;
   };
 
+  // State of a clause under a cube that only fixes some facts.
+  enum class ClauseStatus
+  {
+    // a literal of the clause is in the cube
+    SATISFIED,
+    // every literal of the clause is negated in the cube
+    CONFLICT,
+    // all literals but one are negated in the cube
+    UNIT,
+    OPEN,
+  };
+
   // A set of literals,
   // can represent a clause (disjunction ∨)
   // or a cube (conjunction ∧)
+  //
+  // The literals are stored as a bitmap over the FactIndex. The first
+  // FactIndex::get_num_words() words hold the positive literals, the
+  // remaining words hold the negative literals. All set operations work
+  // on whole words.
   class LiteralSet
   {
   private:
     SetType set_type;
-    std::unordered_set<Literal, LiteralHash> literals;
+    std::vector<uint64_t> bits;
+    std::size_t num_literals;
+    // Zobrist hash: the XOR of a random key per fact, kept separately for
+    // the positive and the negative literals so that invert() only has to
+    // swap them. Updated with every literal that is added or removed.
+    uint64_t positive_hash;
+    uint64_t negative_hash;
+
+    friend class FullState;
+
+    // Recomputes the hash after the bitmap was changed word by word.
+    void recompute_hash();
 
   public:
+    // Iterates over the literals of the set in fact index order,
+    // positive literals first.
+    class const_iterator
+    {
+    private:
+      const LiteralSet *set;
+      std::size_t word;
+      uint64_t remaining;
+
+      void skip_empty_words();
+
+    public:
+      const_iterator(const LiteralSet *set, std::size_t word);
+      Literal operator*() const;
+      const_iterator &operator++();
+      bool operator==(const const_iterator &it) const;
+      bool operator!=(const const_iterator &it) const;
+    };
+
     LiteralSet(SetType type);
     LiteralSet(const Literal &v, SetType type);
-    LiteralSet(const LiteralSet &s);
-    LiteralSet(const std::unordered_set<Literal, LiteralHash> &init_literals, SetType type);
-    LiteralSet &operator=(const LiteralSet &s);
+    LiteralSet(const std::vector<Literal> &init_literals, SetType type);
     bool operator==(const LiteralSet &s) const;
     bool operator!=(const LiteralSet &s) const;
     friend std::ostream &operator<<(std::ostream &os, const LiteralSet &ls);
-    const std::unordered_set<Literal, LiteralHash> &get_literals() const;
+    const_iterator begin() const;
+    const_iterator end() const;
     SetType get_set_type() const;
 
     LiteralSet invert() const;
@@ -91,6 +169,11 @@ namespace pdr_search
     void apply_cube(const LiteralSet &l);
     bool contains_literal(const Literal &l) const;
     bool is_subset_eq_of(const LiteralSet &ls) const;
+    // Returns true if exactly one literal of this set is not in ls,
+    // it is stored in missing.
+    bool misses_one_literal_of(const LiteralSet &ls, Literal &missing) const;
+    // The OR of all words: if a ⊆ b then a.get_signature() & ~b.get_signature() == 0.
+    uint64_t get_signature() const;
     LiteralSet set_union(const LiteralSet &s) const;
     size_t set_intersect_size(const LiteralSet &s) const;
     LiteralSet set_minus(const LiteralSet &s) const;
@@ -103,6 +186,17 @@ namespace pdr_search
     bool models(const LiteralSet &c) const;
     // returns true if this literal set models every clause in the layer
     bool models(const Layer &l) const;
+    // Returns true if no literal of ls is negated in this set.
+    bool is_consistent_with(const LiteralSet &ls) const;
+    // For a cube that only fixes some facts: returns true if a state
+    // that models this cube can model the clause c, i.e. not every
+    // literal of c is negated in this cube.
+    bool may_model(const LiteralSet &c) const;
+    // returns true if this cube may model every clause in the layer
+    bool may_model(const Layer &l) const;
+    // For a cube that only fixes some facts: returns the status of the
+    // clause c, for a unit clause the remaining literal is stored in unit.
+    ClauseStatus get_clause_status(const LiteralSet &c, Literal &unit) const;
 
 
     std::size_t hash() const;
@@ -113,24 +207,130 @@ namespace pdr_search
     std::size_t operator () (LiteralSet const &v) const;
   };
 
+  // A complete assignment, stored as one value per variable.
+  // Obligation states are always complete, so this avoids listing every
+  // fact of the task as a literal and checks each literal in O(1).
+  // The true facts are additionally kept as a bitmap over the FactIndex,
+  // so whole literal sets can be checked word by word.
+  class FullState
+  {
+  private:
+    std::vector<int> values;
+    std::vector<uint64_t> facts;
+
+    void set_fact(int variable, int value, bool state);
+
+  public:
+    FullState(const std::vector<int> &values);
+    bool operator==(const FullState &s) const;
+    bool operator!=(const FullState &s) const;
+    friend std::ostream &operator<<(std::ostream &os, const FullState &s);
+    int operator[](int variable) const;
+    std::size_t size() const;
+
+    // Sets the value of every variable with a positive literal in the cube.
+    void apply_cube(const LiteralSet &c);
+    bool models(const Literal &l) const;
+    // For a clause at least one literal has to hold,
+    // for a cube all literals have to hold.
+    bool models(const LiteralSet &ls) const;
+    // returns true if this state models every clause in the layer
+    bool models(const Layer &l) const;
+    LiteralSet to_cube() const;
+
+    std::size_t hash() const;
+  };
+
   class Obligation
   {
   private:
-    // Parent pointer to recover witnessing path.
-    // Defined in SUDA 3.2
-    std::shared_ptr<Obligation> parent;
-    LiteralSet state;
+    FullState state;
     int priority;
+    // Index of the parent obligation in the ObligationManager to recover
+    // the witnessing path, NO_PARENT for the root.
+    // Defined in SUDA 3.2
+    int parent;
 
   public:
-    Obligation(const LiteralSet &s, int priority, std::shared_ptr<Obligation> parent);
-    Obligation(const Obligation &o);
-    Obligation &operator=(const Obligation &o);
+    static const int NO_PARENT = -1;
+
+    Obligation(FullState s, int priority, int parent);
     friend std::ostream &operator<<(std::ostream &os, const Obligation &o);
     int get_priority() const;
-    LiteralSet get_state() const;
+    void set_priority(int priority);
+    const FullState &get_state() const;
     bool operator<(const Obligation &o) const;
-    const std::shared_ptr<Obligation> get_parent() const;
+    int get_parent() const;
+  };
+
+  enum class ObligationTieBreaking
+  {
+    LIFO,
+    FIFO,
+  };
+
+  // Owns the obligations of one PDR iteration and schedules them.
+  //
+  // Obligations are stored in an arena and refer to each other by index,
+  // they are released together with clear(). The queue is a bucket queue
+  // indexed by priority (the layer of the obligation), obligations with
+  // the smallest priority are returned first.
+  class ObligationManager
+  {
+  private:
+    ObligationTieBreaking tie_breaking;
+    std::vector<Obligation> obligations;
+    std::vector<std::deque<int>> buckets;
+    std::size_t min_bucket;
+    std::size_t num_queued;
+
+  public:
+    ObligationManager(ObligationTieBreaking tie_breaking);
+    // Creates a new obligation and returns its index.
+    int create(FullState s, int priority, int parent);
+    const Obligation &get(int ob) const;
+    // Changes the priority of an obligation that is not queued.
+    void set_priority(int ob, int priority);
+    // Inserts the obligation into the queue.
+    void push(int ob);
+    // Removes and returns the obligation with the smallest priority.
+    int pop();
+    // The priority of the obligation that pop returns next.
+    int get_min_priority() const;
+    // The next obligations of the smallest priority that pop returns if
+    // nothing is pushed meanwhile, at most n.
+    std::vector<int> peek(std::size_t n) const;
+    bool empty() const;
+    std::size_t size() const;
+    // Releases all obligations.
+    void clear();
+    // Releases all obligations but obs and their ancestors and empties the
+    // queue. Returns the new indices of obs.
+    std::vector<int> keep(const std::vector<int> &obs);
+  };
+
+  std::vector<int_packer::IntPacker::Bin> pack_state(const int_packer::IntPacker &packer, const FullState &s);
+
+  // Remembers for complete states the highest layer at which they are
+  // known to be blocked, i.e. extend found no successor in the layer below
+  // and a clause excluding the state was added. Since L_0 ⊆ L_1 ⊆ ...,
+  // a state blocked at layer i is blocked at all layers j ≤ i as well.
+  // The cache is kept across PDR iterations; states are stored packed.
+  class BlockedStateCache
+  {
+  private:
+    const int_packer::IntPacker &packer;
+    utils::HashMap<std::vector<int_packer::IntPacker::Bin>, int> blocked;
+
+  public:
+    BlockedStateCache(const int_packer::IntPacker &packer);
+    void set_blocked(const FullState &s, int layer);
+    // Returns the highest layer at which s is known to be blocked, or -1.
+    int get_blocked_layer(const FullState &s) const;
+    std::size_t size() const;
+    // Forgets all states, e.g. once the clauses excluding them may have
+    // been removed from the layers.
+    void clear();
   };
 
   class SetOfLiteralSets
@@ -138,6 +338,8 @@ namespace pdr_search
   protected:
     SetType set_type;
     std::unordered_set<LiteralSet, LiteralSetHash> sets;
+    // XOR of the hashes of all sets, updated in add_set
+    std::size_t sets_hash;
 
   public:
     SetOfLiteralSets();
@@ -149,7 +351,7 @@ namespace pdr_search
     bool operator==(const SetOfLiteralSets &s) const;
     friend std::ostream &operator<<(std::ostream &os, const SetOfLiteralSets &l);
     size_t size() const;
-    const std::unordered_set<LiteralSet, LiteralSetHash> get_sets() const;
+    const std::unordered_set<LiteralSet, LiteralSetHash> &get_sets() const;
     void add_set(const LiteralSet &s);
     bool contains_set(const LiteralSet &s) const;
     bool is_subset_eq_of(const SetOfLiteralSets &s) const;
@@ -162,13 +364,158 @@ namespace pdr_search
     std::size_t operator () (SetOfLiteralSets const &v) const;
   };
 
+  // The clauses of a layer that are not part of its child layer.
+  //
+  // Clauses are kept in an append log in insertion order. Removing a
+  // clause leaves a tombstone in the log, so clauses can be added and
+  // removed while the delta is being iterated. The log is compacted once
+  // it consists mostly of tombstones and no DeltaSnapshot is active.
+  class LayerDelta
+  {
+  private:
+    // maps each clause to its position in the log
+    std::unordered_map<LiteralSet, std::size_t, LiteralSetHash> positions;
+    std::vector<const LiteralSet *> log;
+    // For every log position the stamp of the clause. A clause that is
+    // moved between deltas keeps its stamp.
+    std::vector<std::size_t> stamps;
+    // shared by all layers, also of the searches of a portfolio
+    static std::atomic<std::size_t> next_stamp;
+    // For every log position the signature of the clause.
+    std::vector<uint64_t> signatures;
+    // For every log position the activity of the clause, see
+    // ClauseDatabase. It is bookkeeping and does not change the clauses,
+    // so it can be bumped through a const layer. A clause that is moved
+    // between deltas keeps its activity.
+    mutable std::vector<double> activities;
+    std::size_t num_tombstones;
+    mutable int active_snapshots;
+    // For every variable the log positions of the clauses that contain a
+    // literal over the variable. Removed clauses stay in the lists until
+    // the log is compacted, so erase does not have to search them.
+    std::vector<std::vector<std::size_t>> occurrences;
+
+    void add_occurrences(const LiteralSet *c, std::size_t position);
+    void compact();
+
+    friend class DeltaSnapshot;
+
+  public:
+    // Visits the clauses that were in the log when the iterator was
+    // created and have not been removed since.
+    class const_iterator
+    {
+    private:
+      const std::vector<const LiteralSet *> *log;
+      std::size_t index;
+      std::size_t end_index;
+
+      void skip_tombstones();
+
+    public:
+      const_iterator(const std::vector<const LiteralSet *> *log, std::size_t index, std::size_t end_index);
+      const LiteralSet &operator*() const;
+      const LiteralSet *operator->() const;
+      const_iterator &operator++();
+      bool operator==(const const_iterator &it) const;
+      bool operator!=(const const_iterator &it) const;
+    };
+
+    LayerDelta();
+    LayerDelta(const LayerDelta &d);
+    LayerDelta &operator=(const LayerDelta &d) = delete;
+
+    // Returns the stored clause, or nullptr if the clause was already present.
+    const LiteralSet *insert(const LiteralSet &c);
+    const LiteralSet *insert(const LiteralSet &c, std::size_t stamp, double activity = 0);
+    bool erase(const LiteralSet &c);
+    bool contains(const LiteralSet &c) const;
+    std::size_t size() const;
+    bool empty() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    // Returns the log positions of the clauses that contain a literal over
+    // the variable. Use get_clause to access them.
+    const std::vector<std::size_t> &get_occurrences(int variable) const;
+    // Returns the clause at a log position, or nullptr if it was removed.
+    const LiteralSet *get_clause(std::size_t position) const;
+    std::size_t get_num_positions() const;
+    std::size_t get_stamp(std::size_t position) const;
+    uint64_t get_signature(std::size_t position) const;
+    // Returns the stamp of a clause of the delta.
+    std::size_t get_stamp(const LiteralSet &c) const;
+    double get_activity(std::size_t position) const;
+    double get_activity(const LiteralSet &c) const;
+    // Returns false if c is not in the delta.
+    bool bump_activity(const LiteralSet &c, double amount) const;
+    void scale_activities(double factor) const;
+    // An estimate of the bytes held by the delta.
+    std::size_t get_memory_usage() const;
+    // An estimate of the bytes that the delta holds for one clause.
+    static std::size_t get_clause_memory(const LiteralSet &c);
+    // Stamps of new clauses are increasing over all deltas.
+    static std::size_t get_next_stamp();
+  };
+
+  // Fixes the clauses of a delta that are visited.
+  // Clauses added to the delta afterwards are not visited, removed clauses
+  // are skipped. While a snapshot exists the delta is not compacted, so
+  // the layers can be modified while iterating over the snapshot.
+  class DeltaSnapshot
+  {
+  private:
+    const LayerDelta &delta;
+    std::size_t end_index;
+
+  public:
+    DeltaSnapshot(const LayerDelta &delta);
+    DeltaSnapshot(const DeltaSnapshot &s) = delete;
+    DeltaSnapshot &operator=(const DeltaSnapshot &s) = delete;
+    ~DeltaSnapshot();
+    LayerDelta::const_iterator begin() const;
+    LayerDelta::const_iterator end() const;
+  };
+
   class Layer 
   {
   private:
      std::shared_ptr<Layer> parent;
      std::shared_ptr<Layer> child;
-     std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> __sets;
+     std::shared_ptr<LayerDelta> delta;
+     // Incremented whenever a clause is added to the layer, i.e. to its
+     // delta or to the delta of a child, that was not in it before, and
+     // whenever a clause is removed from it with remove_set.
+     std::size_t version;
+     // Clauses inserted before this stamp were already simplified.
+     std::size_t simplified_stamp;
+
+     // Removes the clauses of the delta that d subsumes and strengthens
+     // the clauses that can be resolved with d.
+     std::size_t simplify_with(const LiteralSet *d);
+     // Returns true if c ∈ delta is subsumed by a clause of the layer with
+     // a stamp before since. Otherwise a literal of c that can be removed
+     // by resolution is stored in resolved.
+     bool is_subsumed(const LiteralSet *c, std::size_t since, tl::optional<Literal> &resolved) const;
   public:
+    // Iterates over all clauses of a layer, i.e. over its delta and the
+    // deltas of all its children, without copying them.
+    class const_iterator
+    {
+    private:
+      const Layer *layer;
+      LayerDelta::const_iterator it;
+
+      void skip_empty_deltas();
+
+    public:
+      const_iterator(const Layer *layer);
+      const LiteralSet &operator*() const;
+      const LiteralSet *operator->() const;
+      const_iterator &operator++();
+      bool operator==(const const_iterator &it) const;
+      bool operator!=(const const_iterator &it) const;
+    };
+
     Layer(std::shared_ptr<Layer> child, std::shared_ptr<Layer> parent);
     Layer(const Layer &l);
     Layer(const std::unordered_set<LiteralSet> &clauses,std::shared_ptr<Layer> child, std::shared_ptr<Layer> parent);
@@ -176,19 +523,34 @@ namespace pdr_search
     friend std::ostream &operator<<(std::ostream &os, const Layer &l);
     void set_child(std::shared_ptr<Layer> c);
 
-    const std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> get_sets() const;
+    const_iterator begin() const;
+    const_iterator end() const;
     bool contains_set(const LiteralSet &ls) const;
     std::shared_ptr<Layer> get_child() const;
     // Automatically adds the set also to the parents of the set (L_{j}) for j = 0,...,i-1
     // See Suda, 3.6.1 Representation of the Layers
     void add_set(const LiteralSet &c);
-    // Returns a list of literal sets that are in the current layer but not in its child layer.
-    const std::shared_ptr<std::unordered_set<LiteralSet, LiteralSetHash>> get_delta() const;
+    // Removes c from the delta, i.e. from this layer and its parents. The
+    // layers only get weaker and L_{i+1} ⊆ L_i still holds, but clauses of
+    // the child layers may no longer be inductive relative to this layer.
+    // Returns false if c is not in the delta.
+    bool remove_set(const LiteralSet &c);
+    // Adds amount to the activity of c, which is in the delta of this
+    // layer or of a child layer.
+    void bump_activity(const LiteralSet &c, double amount) const;
+    // Returns the literal sets that are in the current layer but not in its child layer.
+    const LayerDelta &get_delta() const;
+    // The layer contains the same clauses as long as the version is unchanged.
+    std::size_t get_version() const;
 
     bool is_subset_eq_of(const Layer &s) const;
     size_t size() const;
 
-    void simplify();
+    // Removes the clauses of the delta that are implied by a single clause
+    // of this layer or of a child layer and strengthens clauses by
+    // self-subsuming resolution. The layers keep the same states and
+    // L_{i+1} ⊆ L_i still holds. Returns the number of changed clauses.
+    std::size_t simplify();
     void print_stack() const;
 
   };
@@ -0,0 +1,135 @@
+#include "goal-states.h"
+
+#include <iostream>
+#include <limits>
+
+namespace pdr_search
+{
+  GoalStateFinder::GoalStateFinder(const std::vector<FactPair> &goal, const FullState &preferred) :
+      num_queries(0),
+      num_clauses(0)
+  {
+    // the variable of a fact is its fact index
+    for (std::size_t f = 0; f < FactIndex::get_num_facts(); f++)
+    {
+      solver.new_variable();
+      const FactPair &fact = FactIndex::get_fact(f);
+      preferred_facts.push_back(preferred[fact.var] == fact.value);
+    }
+    for (int var = 0; var < FactIndex::get_num_variables(); var++)
+    {
+      std::vector<int> values;
+      for (int value = 0; value < FactIndex::get_domain_size(var); value++)
+      {
+        values.push_back(SATSolver::make_literal(FactIndex::get_index(var, value)));
+      }
+      solver.add_clause(values);
+      for (std::size_t i = 0; i < values.size(); i++)
+      {
+        for (std::size_t j = i + 1; j < values.size(); j++)
+        {
+          solver.add_clause({SATSolver::negate(values[i]), SATSolver::negate(values[j])});
+        }
+      }
+    }
+    for (const FactPair &g : goal)
+    {
+      solver.add_clause({SATSolver::make_literal(FactIndex::get_index(g.var, g.value))});
+    }
+  }
+
+  GoalStateFinder::Activation &GoalStateFinder::get_activation(const Layer *layer)
+  {
+    auto it = activations.find(layer);
+    if (it == activations.end())
+    {
+      Activation activation;
+      activation.literal = SATSolver::make_literal(solver.new_variable());
+      activation.version = std::numeric_limits<std::size_t>::max();
+      it = activations.emplace(layer, std::move(activation)).first;
+    }
+    return it->second;
+  }
+
+  void GoalStateFinder::add_layer_clauses(const Layer &L, std::vector<int> &assumptions)
+  {
+    for (const Layer *layer = &L; layer != nullptr; layer = layer->get_child().get())
+    {
+      Activation &activation = get_activation(layer);
+      assumptions.push_back(activation.literal);
+      if (activation.version == layer->get_version())
+      {
+        continue;
+      }
+      const LayerDelta &delta = layer->get_delta();
+      for (std::size_t position = 0; position < delta.get_num_positions(); position++)
+      {
+        const LiteralSet *c = delta.get_clause(position);
+        if (c == nullptr || !activation.stamps.insert(delta.get_stamp(position)).second)
+        {
+          continue;
+        }
+        std::vector<int> clause = {SATSolver::negate(activation.literal)};
+        for (const auto &l : *c)
+        {
+          clause.push_back(SATSolver::make_literal(l.get_fact_index(), !l.is_positive()));
+        }
+        solver.add_clause(clause);
+        num_clauses += 1;
+      }
+      activation.version = layer->get_version();
+    }
+  }
+
+  tl::optional<FullState> GoalStateFinder::find(const Layer &L)
+  {
+    num_queries += 1;
+    std::vector<int> assumptions;
+    add_layer_clauses(L, assumptions);
+    // the saved phases of the previous query would lead away from the
+    // preferred state
+    for (std::size_t f = 0; f < preferred_facts.size(); f++)
+    {
+      solver.set_polarity(f, preferred_facts[f]);
+    }
+    if (!solver.solve(assumptions))
+    {
+      return tl::nullopt;
+    }
+    std::vector<int> values(FactIndex::get_num_variables());
+    for (std::size_t f = 0; f < FactIndex::get_num_facts(); f++)
+    {
+      if (solver.get_model_value(f))
+      {
+        values[FactIndex::get_fact(f).var] = FactIndex::get_fact(f).value;
+      }
+    }
+    return FullState(values);
+  }
+
+  void GoalStateFinder::exclude(const FullState &s, const Layer &L)
+  {
+    std::vector<int> clause = {SATSolver::negate(get_activation(&L).literal)};
+    for (std::size_t var = 0; var < s.size(); var++)
+    {
+      clause.push_back(SATSolver::make_literal(FactIndex::get_index(var, s[var]), true));
+    }
+    solver.add_clause(clause);
+  }
+
+  void GoalStateFinder::forget_layer_clauses()
+  {
+    for (const auto &activation : activations)
+    {
+      solver.add_clause({SATSolver::negate(activation.second.literal)});
+    }
+    activations.clear();
+    solver.remove_satisfied_clauses();
+  }
+
+  void GoalStateFinder::print_statistics() const
+  {
+    std::cout << "Goal state queries: " << num_queries << std::endl;
+    std::cout << "Goal state layer clauses: " << num_clauses << std::endl;
+  }
+}
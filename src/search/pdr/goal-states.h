@@ -0,0 +1,64 @@
+#ifndef PDR_GOAL_STATES_H
+#define PDR_GOAL_STATES_H
+
+#include "data-structures.h"
+#include "sat-solver.h"
+
+#include <optional.hh>
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pdr_search
+{
+  // Finds goal states in a layer, the root obligations of the backward
+  // search, with an incremental SAT solver.
+  //
+  // The solver has one variable per fact, every variable has exactly one
+  // value and the goal facts hold. Like in SATExtender, the clauses of a
+  // layer delta are guarded by an activation literal of the layer and
+  // added when the version of a queried layer has changed. States that
+  // were returned as roots are excluded with a clause guarded by the
+  // activation literal of the queried layer.
+  class GoalStateFinder
+  {
+  private:
+    struct Activation
+    {
+      int literal;
+      std::size_t version;
+      // stamps of the clauses of the delta that were added
+      std::unordered_set<std::size_t> stamps;
+    };
+
+    SATSolver solver;
+    // for every fact whether it is tried first
+    std::vector<bool> preferred_facts;
+    std::unordered_map<const Layer *, Activation> activations;
+    std::size_t num_queries;
+    std::size_t num_clauses;
+
+    Activation &get_activation(const Layer *layer);
+    void add_layer_clauses(const Layer &L, std::vector<int> &assumptions);
+
+  public:
+    // The values of the preferred state are tried first for the
+    // variables that the goal leaves open.
+    GoalStateFinder(const std::vector<FactPair> &goal, const FullState &preferred);
+
+    // Returns a goal state in L that was not excluded from L.
+    tl::optional<FullState> find(const Layer &L);
+    // Excludes the goal state s from L in later calls. This is only
+    // correct if the clauses of L exclude s by then, e.g. because s is a
+    // root obligation at L and blocked before L is queried again.
+    void exclude(const FullState &s, const Layer &L);
+    // Disables the layer clauses and the excluded states so far, needed
+    // once clauses were removed from the layers.
+    void forget_layer_clauses();
+    void print_statistics() const;
+  };
+}
+
+#endif
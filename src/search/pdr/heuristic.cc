@@ -7,12 +7,18 @@ namespace pdr_search
   PDRHeuristic::PDRHeuristic(const options::Options &opts) : task(opts.get<std::shared_ptr<AbstractTask>>("transform")),
                                                              task_proxy(*task)
   {
+    FactIndex::initialize(*task);
   }
 
   pdr_search::PDRHeuristic::~PDRHeuristic()
   {
   }
 
+  bool PDRHeuristic::holds_in_reachable_states() const
+  {
+    return false;
+  }
+
   void PDRHeuristic::add_options_to_parser(OptionParser &parser)
   {
     parser.add_option<std::shared_ptr<AbstractTask>>(
@@ -34,6 +40,11 @@ namespace pdr_search
   {
   }
 
+  bool NoopPDRHeuristic::holds_in_reachable_states() const
+  {
+    return true;
+  }
+
   std::shared_ptr<PDRHeuristic> NoopPDRHeuristic::parse(OptionParser &parser)
   {
     parser.document_synopsis("noop for pdr search", "");
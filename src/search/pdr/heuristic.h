@@ -27,6 +27,10 @@ namespace pdr_search
     PDRHeuristic(const options::Options &opts);
     virtual ~PDRHeuristic();
     virtual void initial_heuristic_layer(int i, std::shared_ptr<Layer> layer) = 0;
+    // Returns true if the seeded clauses hold in every state reachable
+    // from the initial state, so they can seed the layers of backward PDR
+    // as well. Clauses derived from goal distances only hold forward.
+    virtual bool holds_in_reachable_states() const;
 
     static void add_options_to_parser(OptionParser &parser);
   };
@@ -37,6 +41,7 @@ namespace pdr_search
     NoopPDRHeuristic(const options::Options &opts);
     ~NoopPDRHeuristic();
     virtual void initial_heuristic_layer(int i, std::shared_ptr<Layer> layer);
+    virtual bool holds_in_reachable_states() const;
     static std::shared_ptr<PDRHeuristic> parse(OptionParser &parser);
   };
 
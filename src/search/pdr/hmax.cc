@@ -0,0 +1,145 @@
+#include "hmax.h"
+#include "../plugin.h"
+#include <algorithm>
+#include <memory>
+
+namespace pdr_search
+{
+  HMaxPDRHeuristic::HMaxPDRHeuristic(const options::Options &opts) : PDRHeuristic(opts)
+  {
+    int num_facts = FactIndex::get_num_facts();
+
+    // For every fact the conditions of the operators (and conditional
+    // effects) adding it. An empty condition makes the fact reachable
+    // from every state.
+    std::vector<std::vector<std::vector<int>>> achievers(num_facts);
+    for (OperatorProxy op : task_proxy.get_operators())
+    {
+      std::vector<int> pre;
+      for (FactProxy fact : op.get_preconditions())
+      {
+        pre.push_back(FactIndex::get_index(fact.get_variable().get_id(), fact.get_value()));
+      }
+      for (EffectProxy effect : op.get_effects())
+      {
+        std::vector<int> condition = pre;
+        for (FactProxy fact : effect.get_conditions())
+        {
+          condition.push_back(FactIndex::get_index(fact.get_variable().get_id(), fact.get_value()));
+        }
+        FactProxy fact = effect.get_fact();
+        achievers[FactIndex::get_index(fact.get_variable().get_id(), fact.get_value())].push_back(condition);
+      }
+    }
+
+    std::vector<LiteralSet> reachable_from;
+    std::vector<bool> trivial(num_facts, false);
+    for (int f = 0; f < num_facts; f++)
+    {
+      const FactPair &fact = FactIndex::get_fact(f);
+      reachable_from.push_back(LiteralSet(Literal(fact.var, fact.value), SetType::CLAUSE));
+    }
+
+    std::vector<int> goals;
+    for (FactProxy goal : task_proxy.get_goals())
+    {
+      goals.push_back(FactIndex::get_index(goal.get_variable().get_id(), goal.get_value()));
+    }
+
+    // whether R(f) changed in the last round
+    std::vector<bool> renewed(num_facts, true);
+    bool changed = true;
+    while (changed)
+    {
+      // A clause that did not change in the last round is not added
+      // again, it stays in the delta of the layer where it first appeared.
+      std::vector<LiteralSet> goal_clauses;
+      for (int g : goals)
+      {
+        if (!trivial[g] && renewed[g])
+        {
+          goal_clauses.push_back(reachable_from[g]);
+        }
+      }
+      clauses_by_layer.push_back(goal_clauses);
+
+      changed = false;
+      std::vector<LiteralSet> next = reachable_from;
+      std::vector<bool> next_trivial = trivial;
+      std::fill(renewed.begin(), renewed.end(), false);
+      for (int f = 0; f < num_facts; f++)
+      {
+        if (trivial[f])
+        {
+          continue;
+        }
+        for (const auto &condition : achievers[f])
+        {
+          // the condition fact with the fewest facts reaching it
+          int best = -1;
+          for (int p : condition)
+          {
+            if (!trivial[p] && (best == -1 || reachable_from[p].size() < reachable_from[best].size()))
+            {
+              best = p;
+            }
+          }
+          if (best == -1)
+          {
+            next_trivial[f] = true;
+            changed = true;
+            break;
+          }
+          if (!reachable_from[best].is_subset_eq_of(next[f]))
+          {
+            next[f] = next[f].set_union(reachable_from[best]);
+            renewed[f] = true;
+            changed = true;
+          }
+        }
+      }
+      reachable_from.swap(next);
+      trivial.swap(next_trivial);
+    }
+
+    std::size_t num_clauses = 0;
+    for (const auto &clauses : clauses_by_layer)
+    {
+      num_clauses += clauses.size();
+    }
+    std::cout << "Relaxed reachability layers: " << clauses_by_layer.size()
+              << ", clauses: " << num_clauses << std::endl;
+  }
+
+  void HMaxPDRHeuristic::initial_heuristic_layer(int i, std::shared_ptr<Layer> layer)
+  {
+    if (static_cast<std::size_t>(i) >= clauses_by_layer.size())
+    {
+      return;
+    }
+    for (const LiteralSet &c : clauses_by_layer[i])
+    {
+      layer->add_set(c);
+    }
+  }
+
+  std::shared_ptr<PDRHeuristic> HMaxPDRHeuristic::parse(OptionParser &parser)
+  {
+    parser.document_synopsis("relaxed reachability seeding for pdr search",
+                             "Adds for every goal fact g the clause over the facts from which g "
+                             "can be reached in at most i relaxed steps to layer i.");
+    PDRHeuristic::add_options_to_parser(parser);
+
+    Options opts = parser.parse();
+
+    std::shared_ptr<HMaxPDRHeuristic> heuristic;
+    if (!parser.dry_run())
+    {
+      heuristic = std::make_shared<HMaxPDRHeuristic>(opts);
+    }
+
+    return heuristic;
+  }
+
+  static Plugin<PDRHeuristic> _pluginHMax("pdr-hmax", HMaxPDRHeuristic::parse);
+}
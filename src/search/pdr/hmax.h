@@ -0,0 +1,37 @@
+#ifndef PDR_HMAX_H
+#define PDR_HMAX_H
+
+#include "heuristic.h"
+#include "../option_parser.h"
+#include <memory>
+#include <vector>
+
+namespace pdr_search
+{
+  // Seeds the layers with relaxed reachability clauses for the goal facts.
+  //
+  // R_i(f) is the set of facts from which f can be reached in at most i
+  // relaxed steps (h^max in the regression sense), where an operator
+  // adding f only contributes the facts of one of its preconditions:
+  //   R_0(f) = {f},
+  //   R_i(f) = R_i-1(f) ∪ ⋃_{a adds f} R_i-1(p_a) for some p_a ∈ pre(a).
+  // A state that reaches f within i steps contains a fact of R_i(f), so
+  // layer i gets the positive clause ∨ R_i(g) for every goal fact g with
+  // R_i(g) ≠ R_i-1(g). Added to layer i the clause is part of all layers
+  // below as well, so the layers above the last change of R(g) are not
+  // seeded with it again.
+  // If an operator without preconditions adds f, R_i(f) is every fact
+  // and gives no clause.
+  class HMaxPDRHeuristic : public PDRHeuristic
+  {
+  private:
+    // the clauses that are new in layer i, further layers get none
+    std::vector<std::vector<LiteralSet>> clauses_by_layer;
+
+  public:
+    HMaxPDRHeuristic(const options::Options &opts);
+    virtual void initial_heuristic_layer(int i, std::shared_ptr<Layer> layer);
+    static std::shared_ptr<PDRHeuristic> parse(OptionParser &parser);
+  };
+}
+#endif
@@ -0,0 +1,195 @@
+#include "mutex.h"
+#include "../plugin.h"
+#include "../task_utils/task_properties.h"
+#include "../utils/system.h"
+#include <memory>
+
+namespace pdr_search
+{
+  MutexPDRHeuristic::MutexPDRHeuristic(const options::Options &opts) : PDRHeuristic(opts)
+  {
+    bool use_translator = opts.get<bool>("translator");
+    bool use_h2 = opts.get<bool>("h2");
+    if (use_h2 && task_properties::has_axioms(task_proxy))
+    {
+      std::cerr << "h^2 mutexes do not support axioms" << std::endl;
+      utils::exit_with(utils::ExitCode::SEARCH_UNSUPPORTED);
+    }
+
+    std::vector<std::vector<bool>> reachable;
+    if (use_h2)
+    {
+      reachable = compute_h2_reachable_pairs();
+    }
+
+    int num_facts = FactIndex::get_num_facts();
+    std::size_t num_unreachable = 0;
+    for (int p = 0; p < num_facts; p++)
+    {
+      const FactPair &fact_p = FactIndex::get_fact(p);
+      if (use_h2 && !reachable[p][p])
+      {
+        clauses.push_back(LiteralSet(Literal(fact_p.var, fact_p.value, false), SetType::CLAUSE));
+        num_unreachable += 1;
+        continue;
+      }
+      for (int q = p + 1; q < num_facts; q++)
+      {
+        const FactPair &fact_q = FactIndex::get_fact(q);
+        // a state assigns one value per variable anyway
+        if (fact_p.var == fact_q.var || (use_h2 && !reachable[q][q]))
+        {
+          continue;
+        }
+        if ((use_translator && task->are_facts_mutex(fact_p, fact_q)) ||
+            (use_h2 && !reachable[p][q]))
+        {
+          LiteralSet c = LiteralSet(SetType::CLAUSE);
+          c.add_literal(Literal(fact_p.var, fact_p.value, false));
+          c.add_literal(Literal(fact_q.var, fact_q.value, false));
+          clauses.push_back(c);
+        }
+      }
+    }
+    std::cout << "Mutex clauses: " << clauses.size() - num_unreachable
+              << ", unreachable facts: " << num_unreachable << std::endl;
+  }
+
+  std::vector<std::vector<bool>> MutexPDRHeuristic::compute_h2_reachable_pairs() const
+  {
+    int num_facts = FactIndex::get_num_facts();
+    std::vector<std::vector<bool>> reachable(num_facts, std::vector<bool>(num_facts, false));
+    bool changed = false;
+    auto mark = [&](int p, int q)
+    {
+      if (!reachable[p][q])
+      {
+        reachable[p][q] = true;
+        reachable[q][p] = true;
+        changed = true;
+      }
+    };
+
+    std::vector<int> init;
+    for (FactProxy fact : task_proxy.get_initial_state())
+    {
+      init.push_back(FactIndex::get_index(fact.get_variable().get_id(), fact.get_value()));
+    }
+    for (int p : init)
+    {
+      for (int q : init)
+      {
+        mark(p, q);
+      }
+    }
+
+    std::vector<bool> deleted(FactIndex::get_num_variables(), false);
+    do
+    {
+      changed = false;
+      for (OperatorProxy op : task_proxy.get_operators())
+      {
+        std::vector<int> pre;
+        for (FactProxy fact : op.get_preconditions())
+        {
+          pre.push_back(FactIndex::get_index(fact.get_variable().get_id(), fact.get_value()));
+        }
+        bool applicable = true;
+        for (std::size_t i = 0; i < pre.size() && applicable; i++)
+        {
+          for (std::size_t j = i; j < pre.size() && applicable; j++)
+          {
+            applicable = reachable[pre[i]][pre[j]];
+          }
+        }
+        if (!applicable)
+        {
+          continue;
+        }
+
+        // Conditional effects may add their fact, but only unconditional
+        // effects are certain to change their variable. This over-approximates
+        // the reachable pairs, so the resulting mutexes are sound.
+        std::vector<int> eff;
+        for (EffectProxy effect : op.get_effects())
+        {
+          FactProxy fact = effect.get_fact();
+          eff.push_back(FactIndex::get_index(fact.get_variable().get_id(), fact.get_value()));
+          if (effect.get_conditions().empty())
+          {
+            deleted[fact.get_variable().get_id()] = true;
+          }
+        }
+        for (int e : eff)
+        {
+          for (int f : eff)
+          {
+            mark(e, f);
+          }
+          // facts that survive the operator and are reachable together with pre
+          for (int q = 0; q < num_facts; q++)
+          {
+            if (deleted[FactIndex::get_fact(q).var] || !reachable[q][q])
+            {
+              continue;
+            }
+            bool compatible = true;
+            for (std::size_t i = 0; i < pre.size() && compatible; i++)
+            {
+              compatible = reachable[q][pre[i]];
+            }
+            if (compatible)
+            {
+              mark(e, q);
+            }
+          }
+        }
+        for (EffectProxy effect : op.get_effects())
+        {
+          deleted[effect.get_fact().get_variable().get_id()] = false;
+        }
+      }
+    } while (changed);
+    return reachable;
+  }
+
+  void MutexPDRHeuristic::initial_heuristic_layer(int, std::shared_ptr<Layer> layer)
+  {
+    // The clauses of the previous layer are moved to the new top layer.
+    for (const LiteralSet &c : clauses)
+    {
+      layer->add_set(c);
+    }
+  }
+
+  bool MutexPDRHeuristic::holds_in_reachable_states() const
+  {
+    return true;
+  }
+
+  std::shared_ptr<PDRHeuristic> MutexPDRHeuristic::parse(OptionParser &parser)
+  {
+    parser.document_synopsis("mutex seeding for pdr search",
+                             "Adds the clause ¬p ∨ ¬q for every mutex pair of facts p, q to every layer.");
+    parser.add_option<bool>("translator", "use the mutex groups of the translator", "true");
+    parser.add_option<bool>("h2", "compute h^2 mutexes from the initial state", "false");
+    parser.document_language_support("axioms", "not supported with h2=true");
+    PDRHeuristic::add_options_to_parser(parser);
+
+    Options opts = parser.parse();
+
+    std::shared_ptr<MutexPDRHeuristic> heuristic;
+    if (!parser.dry_run())
+    {
+      if (!opts.get<bool>("translator") && !opts.get<bool>("h2"))
+      {
+        parser.error("at least one of translator and h2 has to be enabled");
+      }
+      heuristic = std::make_shared<MutexPDRHeuristic>(opts);
+    }
+
+    return heuristic;
+  }
+
+  static Plugin<PDRHeuristic> _pluginMutex("pdr-mutex", MutexPDRHeuristic::parse);
+}
@@ -0,0 +1,31 @@
+#ifndef PDR_MUTEX_H
+#define PDR_MUTEX_H
+
+#include "heuristic.h"
+#include "../option_parser.h"
+#include <memory>
+#include <vector>
+
+namespace pdr_search
+{
+  // Seeds every layer with the clauses ¬p ∨ ¬q of the mutex pairs of the
+  // task. Since no reachable state contains both facts, the clauses hold
+  // in every layer. Mutexes are taken from the translator and optionally
+  // computed with h^2 reachability from the initial state, which also
+  // gives unit clauses ¬p for unreachable facts.
+  class MutexPDRHeuristic : public PDRHeuristic
+  {
+  private:
+    std::vector<LiteralSet> clauses;
+
+    // Returns for every pair of facts if it is reachable according to h^2.
+    std::vector<std::vector<bool>> compute_h2_reachable_pairs() const;
+
+  public:
+    MutexPDRHeuristic(const options::Options &opts);
+    virtual void initial_heuristic_layer(int i, std::shared_ptr<Layer> layer);
+    virtual bool holds_in_reachable_states() const;
+    static std::shared_ptr<PDRHeuristic> parse(OptionParser &parser);
+  };
+}
+#endif
@@ -1,87 +1,139 @@
 #include "pattern-database.h"
 #include "../plugin.h"
+#include "../pdbs/pattern_collection_information.h"
+#include <algorithm>
+#include <limits>
 #include <memory>
 
 namespace pdr_search
 {
-  PatternDBPDRHeuristic::PatternDBPDRHeuristic(const options::Options &opts) : PDRHeuristic(opts)
+  PDBSeedingPDRHeuristic::PDBSeedingPDRHeuristic(const options::Options &opts) : PDRHeuristic(opts)
   {
-
-    std::shared_ptr<pdbs::PatternGenerator> pattern_generator =
-        opts.get<std::shared_ptr<pdbs::PatternGenerator>>("pattern");
-
-    pdbs::PatternInformation pattern_info = pattern_generator->generate(task);
-
-    pattern_database = pattern_info.get_pdb();
-
-    auto pattern = pattern_database->get_pattern();
-    auto variables = TaskProxy(*task).get_variables();
-
-    std::cout << "Pattern size: " << pattern.size() << ", Variables: " << variables.size() << std::endl;
-    std::cout << "Projected states: " << this->pattern_database->get_size() << std::endl;
-    if (pattern.size() == 0) {
-        std::cout << "! Warning: empty pattern" << std::endl;
-    }
   }
 
-  void pdr_search::PatternDBPDRHeuristic::initial_heuristic_layer(int i, std::shared_ptr<Layer> layer)
+  void PDBSeedingPDRHeuristic::add_pattern_databases(const pdbs::PDBCollection &all_pdbs)
   {
-    auto task_proxy = TaskProxy(*task);
-    auto pattern = pattern_database->get_pattern();
     auto variables = task_proxy.get_variables();
-    std::set<LiteralSet> clauses;
-    std::vector<int> current_state(variables.size()); // is initialized with 0 values
 
-    if (pattern.size() < 1) {
-        return;
+    // The clause of an abstract state s only contains literals over the
+    // pattern of its PDB, one for every value that differs from s. So the
+    // clause of an abstract state q of another PDB is a subset of it iff
+    // the pattern of q is a subset and q is the projection of s.
+    pdbs::PDBCollection pdbs;
+    for (const auto &pdb : all_pdbs)
+    {
+      if (pdb->get_pattern().empty())
+      {
+        std::cout << "! Warning: empty pattern" << std::endl;
+        continue;
+      }
+      pdbs.push_back(pdb);
     }
 
-    // first variable in pattern with -1 so we can increment it to 0 in the loop
-    current_state[pattern[0]] = -1;
-    bool done = false;
-
-    while (!done)
+    std::size_t num_subsumed = 0;
+    for (std::size_t p = 0; p < pdbs.size(); p++)
     {
-      // increment first pattern value
-      current_state[pattern[0]] += 1;
-      // propagate value to next pattern values if it overflows.
-      for (size_t ptrnidx = 0; ptrnidx < pattern.size(); ptrnidx += 1)
+      const pdbs::Pattern &pattern = pdbs[p]->get_pattern();
+      std::vector<const pdbs::PatternDatabase *> smaller_pdbs;
+      for (std::size_t q = 0; q < pdbs.size(); q++)
       {
-        if (current_state[pattern[ptrnidx]] == variables[pattern[ptrnidx]].get_domain_size())
+        const pdbs::Pattern &other = pdbs[q]->get_pattern();
+        if (other == pattern ? q < p : std::includes(pattern.begin(), pattern.end(), other.begin(), other.end()))
         {
-          if (ptrnidx >= pattern.size() -1) {
-            done = true;
+          smaller_pdbs.push_back(pdbs[q].get());
+        }
+      }
+
+      std::vector<int> current_state(variables.size()); // is initialized with 0 values
+
+      // first variable in pattern with -1 so we can increment it to 0 in the loop
+      current_state[pattern[0]] = -1;
+      bool done = false;
+
+      while (!done)
+      {
+        // increment first pattern value
+        current_state[pattern[0]] += 1;
+        // propagate value to next pattern values if it overflows.
+        for (size_t ptrnidx = 0; ptrnidx < pattern.size(); ptrnidx += 1)
+        {
+          if (current_state[pattern[ptrnidx]] == variables[pattern[ptrnidx]].get_domain_size())
+          {
+            if (ptrnidx >= pattern.size() -1) {
+              done = true;
+              break;
+            }
+            current_state[pattern[ptrnidx]] = 0;
+            current_state[pattern[ptrnidx + 1]] += 1;
+          }
+          else
+          {
             break;
           }
-          current_state[pattern[ptrnidx]] = 0;
-          current_state[pattern[ptrnidx + 1]] += 1;
         }
-        else
-        {
+        if (done) {
           break;
         }
+
+        // Get the heuristic distance.
+        // Since the heuristic is admissible, the heuristic distance is always smaller or equal to the
+        // real distance.
+        int dist = pdbs[p]->get_value(current_state);
+        if (dist < 0)
+        {
+          dist = std::numeric_limits<int>::max();
+        }
+        // Abstract states with distance 0 are never excluded from a layer.
+        if (dist == 0)
+        {
+          continue;
+        }
+        bool subsumed = false;
+        for (const pdbs::PatternDatabase *smaller : smaller_pdbs)
+        {
+          int smaller_dist = smaller->get_value(current_state);
+          if (smaller_dist < 0 || smaller_dist >= dist)
+          {
+            subsumed = true;
+            break;
+          }
+        }
+        if (subsumed)
+        {
+          num_subsumed += 1;
+          continue;
+        }
+        LiteralSet ls = from_projected_state(pattern, current_state);
+        clauses_by_distance.emplace_back(dist, ls.invert());
       }
-      if (done) {
-        break;
-      }
+    }
 
-      // Get the heuristic distance.
-      // Since the heuristic is admissible, the heuristic distance is always smaller or equal to the
-      // real distance.
-      int dist = pattern_database->get_value(current_state);
-      // If the heuristic distance is <= than the current layer number i,
-      // the goal can be possibly reached from current_state in i steps.
-      if (dist > i || dist < 0)
+    std::stable_sort(clauses_by_distance.begin(), clauses_by_distance.end(),
+                     [](const std::pair<int, LiteralSet> &a, const std::pair<int, LiteralSet> &b)
+                     { return a.first > b.first; });
+
+    std::cout << "Seeding clauses: " << clauses_by_distance.size()
+              << ", subsumed: " << num_subsumed << std::endl;
+  }
+
+  void PDBSeedingPDRHeuristic::initial_heuristic_layer(int i, std::shared_ptr<Layer> layer)
+  {
+    // If the heuristic distance is <= than the current layer number i,
+    // the goal can be possibly reached from the abstract state in i steps.
+    // Otherwise strengthen the layer such that the abstract state can
+    // not model the layer. All these clauses are already part of layer
+    // i-1, so add_set only moves them to the delta of the new layer.
+    for (const auto &entry : clauses_by_distance)
+    {
+      if (entry.first <= i)
       {
-        // Strengthen the layer such that the abstract state of 'current_state'
-        // can not model the layer.
-        LiteralSet ls = from_projected_state(pattern, current_state);
-        layer->add_set(ls.invert());
+        break;
       }
+      layer->add_set(entry.second);
     }
   }
 
-  LiteralSet PatternDBPDRHeuristic::from_projected_state(pdbs::Pattern pattern, std::vector<int> state)
+  LiteralSet PDBSeedingPDRHeuristic::from_projected_state(pdbs::Pattern pattern, std::vector<int> state)
   {
     LiteralSet positives = LiteralSet(SetType::CUBE);
     LiteralSet negatives = LiteralSet(SetType::CUBE);
@@ -89,7 +141,7 @@ namespace pdr_search
     {
       assert(varidx >= 0);
       assert(state[varidx] < task_proxy.get_variables()[varidx].get_domain_size());
-      Literal l = Literal::from_fact(FactProxy(*task, varidx, state[varidx]));
+      Literal l = Literal(varidx, state[varidx]);
       positives.add_literal(l);
     }
     auto vars = this->task_proxy.get_variables();
@@ -98,7 +150,7 @@ namespace pdr_search
       int dom_size = vars[varidx].get_domain_size();
       for (int i = 0; i < dom_size; i++)
       {
-        Literal l = Literal::from_fact(FactProxy(*task, varidx, i));
+        Literal l = Literal(varidx, i);
         if (!positives.contains_literal(l))
         {
           negatives.add_literal(l.invert());
@@ -108,6 +160,25 @@ namespace pdr_search
     return negatives;
   }
 
+  PatternDBPDRHeuristic::PatternDBPDRHeuristic(const options::Options &opts) : PDBSeedingPDRHeuristic(opts)
+  {
+
+    std::shared_ptr<pdbs::PatternGenerator> pattern_generator =
+        opts.get<std::shared_ptr<pdbs::PatternGenerator>>("pattern");
+
+    pdbs::PatternInformation pattern_info = pattern_generator->generate(task);
+
+    std::shared_ptr<pdbs::PatternDatabase> pattern_database = pattern_info.get_pdb();
+
+    auto pattern = pattern_database->get_pattern();
+    auto variables = TaskProxy(*task).get_variables();
+
+    std::cout << "Pattern size: " << pattern.size() << ", Variables: " << variables.size() << std::endl;
+    std::cout << "Projected states: " << pattern_database->get_size() << std::endl;
+
+    add_pattern_databases(pdbs::PDBCollection{pattern_database});
+  }
+
   std::shared_ptr<PDRHeuristic> PatternDBPDRHeuristic::parse(OptionParser &parser)
   {
     parser.document_synopsis("pattern database heuristic for pdr search", "");
@@ -128,6 +199,50 @@ namespace pdr_search
     return heuristic;
   }
 
+  PatternCollectionPDRHeuristic::PatternCollectionPDRHeuristic(const options::Options &opts) : PDBSeedingPDRHeuristic(opts)
+  {
+    std::shared_ptr<pdbs::PatternCollectionGenerator> pattern_generator =
+        opts.get<std::shared_ptr<pdbs::PatternCollectionGenerator>>("patterns");
+
+    pdbs::PatternCollectionInformation pattern_collection_info = pattern_generator->generate(task);
+
+    std::shared_ptr<pdbs::PDBCollection> pdbs = pattern_collection_info.get_pdbs();
+
+    std::size_t num_projected_states = 0;
+    for (const auto &pdb : *pdbs)
+    {
+      num_projected_states += pdb->get_size();
+    }
+    std::cout << "Patterns: " << pdbs->size() << std::endl;
+    std::cout << "Projected states: " << num_projected_states << std::endl;
+
+    add_pattern_databases(*pdbs);
+  }
+
+  std::shared_ptr<PDRHeuristic> PatternCollectionPDRHeuristic::parse(OptionParser &parser)
+  {
+    parser.document_synopsis("pattern collection heuristic for pdr search",
+                             "Seeds the layers with the abstract states of every pattern database "
+                             "of the collection. Clauses that are subsumed by a clause of another "
+                             "pattern database are skipped.");
+    parser.add_option<std::shared_ptr<pdbs::PatternCollectionGenerator>>(
+        "patterns",
+        "pattern collection generation method",
+        "systematic(1)");
+    PDRHeuristic::add_options_to_parser(parser);
+
+    Options opts = parser.parse();
+
+    std::shared_ptr<PatternCollectionPDRHeuristic> heuristic;
+    if (!parser.dry_run())
+    {
+      heuristic = std::make_shared<PatternCollectionPDRHeuristic>(opts);
+    }
+
+    return heuristic;
+  }
+
   static Plugin<PDRHeuristic> _pluginPDB("pdr-pdb", PatternDBPDRHeuristic::parse);
+  static Plugin<PDRHeuristic> _pluginPDBs("pdr-pdbs", PatternCollectionPDRHeuristic::parse);
 
 } // namespace pdr_search
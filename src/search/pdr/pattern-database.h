@@ -5,22 +5,51 @@
 #include "../pdbs/pattern_database.h"
 #include "../pdbs/pattern_information.h"
 #include "../pdbs/pattern_generator.h"
+#include "../pdbs/types.h"
 #include "../option_parser.h"
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace pdr_search
 {
 
-  class PatternDBPDRHeuristic : public PDRHeuristic
+  // Seeds the layers with the abstract states of pattern databases:
+  // layer i excludes every abstract state with goal distance > i.
+  class PDBSeedingPDRHeuristic : public PDRHeuristic
   {
     private:
-      std::shared_ptr<pdbs::PatternDatabase> pattern_database;
+      // The clause excluding each abstract state together with its goal
+      // distance, sorted by decreasing distance. Computed once, layer i
+      // is seeded with the prefix of clauses with distance > i.
+      std::vector<std::pair<int, LiteralSet>> clauses_by_distance;
+
+    protected:
+      PDBSeedingPDRHeuristic(const options::Options &opts);
+
+      // Computes the seeding clauses of all pattern databases. A clause is
+      // skipped if it is subsumed by a clause of an earlier or a smaller
+      // pattern with at least the same distance.
+      void add_pattern_databases(const pdbs::PDBCollection &pdbs);
 
     public:
-      PatternDBPDRHeuristic(const options::Options &opts);
       void initial_heuristic_layer(int i, std::shared_ptr<Layer> layer);
 
       LiteralSet from_projected_state(pdbs::Pattern pattern, std::vector<int> state);
+  };
+
+  class PatternDBPDRHeuristic : public PDBSeedingPDRHeuristic
+  {
+    public:
+      PatternDBPDRHeuristic(const options::Options &opts);
+
+      static std::shared_ptr<PDRHeuristic> parse(OptionParser &parser);
+  };
+
+  class PatternCollectionPDRHeuristic : public PDBSeedingPDRHeuristic
+  {
+    public:
+      PatternCollectionPDRHeuristic(const options::Options &opts);
 
       static std::shared_ptr<PDRHeuristic> parse(OptionParser &parser);
   };
@@ -0,0 +1,171 @@
+#include "reasons.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace pdr_search
+{
+  ReasonGeneralizer::ReasonGeneralizer(ReasonMode m) : mode(m)
+  {
+  }
+
+  int ReasonGeneralizer::get_literal_id(const Literal &l)
+  {
+    return 2 * l.get_fact_index() + (l.is_positive() ? 0 : 1);
+  }
+
+  void ReasonGeneralizer::clear()
+  {
+    cubes.clear();
+    cube_family.clear();
+    families.clear();
+  }
+
+  void ReasonGeneralizer::add_family()
+  {
+    families.push_back(std::vector<int>());
+  }
+
+  void ReasonGeneralizer::add_cube(const LiteralSet &cube)
+  {
+    assert(!families.empty());
+    assert(cube.is_cube());
+    families.back().push_back(cubes.size());
+    cube_family.push_back(families.size() - 1);
+    cubes.push_back(cube);
+  }
+
+  std::size_t ReasonGeneralizer::get_num_families() const
+  {
+    return families.size();
+  }
+
+  ReasonMode ReasonGeneralizer::get_mode() const
+  {
+    return mode;
+  }
+
+  void ReasonGeneralizer::add_to_reason(const Literal &l)
+  {
+    for (int c : occurrences[get_literal_id(l)])
+    {
+      missing[c] -= 1;
+      if (missing[c] == 0)
+      {
+        covered[cube_family[c]] += 1;
+      }
+    }
+  }
+
+  void ReasonGeneralizer::remove_from_reason(const Literal &l)
+  {
+    for (int c : occurrences[get_literal_id(l)])
+    {
+      if (missing[c] == 0)
+      {
+        covered[cube_family[c]] -= 1;
+      }
+      missing[c] += 1;
+    }
+  }
+
+  bool ReasonGeneralizer::is_satisfied(const Literal &l) const
+  {
+    for (int c : occurrences[get_literal_id(l)])
+    {
+      if (covered[cube_family[c]] == 0)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  LiteralSet ReasonGeneralizer::compute()
+  {
+    occurrences.resize(2 * FactIndex::get_num_facts());
+    missing.assign(cubes.size(), 0);
+    covered.assign(families.size(), 0);
+    for (std::size_t c = 0; c < cubes.size(); c++)
+    {
+      for (const auto &l : cubes[c])
+      {
+        int id = get_literal_id(l);
+        if (occurrences[id].empty())
+        {
+          used_literal_ids.push_back(id);
+        }
+        occurrences[id].push_back(c);
+        missing[c] += 1;
+      }
+      if (missing[c] == 0)
+      {
+        covered[cube_family[c]] += 1;
+      }
+    }
+
+    // Cover the families with few candidates first.
+    std::vector<int> order(families.size());
+    for (std::size_t f = 0; f < order.size(); f++)
+    {
+      order[f] = f;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int f, int g)
+                     { return families[f].size() < families[g].size(); });
+
+    LiteralSet r = LiteralSet(SetType::CUBE);
+    for (int f : order)
+    {
+      if (covered[f] > 0 || families[f].empty())
+      {
+        continue;
+      }
+      // the cube that adds the fewest literals to r
+      int best = families[f][0];
+      for (int c : families[f])
+      {
+        if (missing[c] < missing[best] ||
+            (missing[c] == missing[best] && cubes[c].hash() < cubes[best].hash()))
+        {
+          best = c;
+        }
+      }
+      for (const auto &l : cubes[best])
+      {
+        if (!r.contains_literal(l))
+        {
+          r.add_literal(l);
+          add_to_reason(l);
+        }
+      }
+      assert(covered[f] > 0);
+    }
+
+    if (mode == ReasonMode::MINIMAL)
+    {
+      // Removing a literal never makes another literal removable,
+      // so one pass gives a reason without unnecessary literals.
+      LiteralSet r_literals = r;
+      for (const auto &l : r_literals)
+      {
+        remove_from_reason(l);
+        if (is_satisfied(l))
+        {
+          r.remove_literal(l);
+        }
+        else
+        {
+          add_to_reason(l);
+        }
+      }
+    }
+
+    for (int id : used_literal_ids)
+    {
+      occurrences[id].clear();
+    }
+    used_literal_ids.clear();
+    clear();
+    return r;
+  }
+}
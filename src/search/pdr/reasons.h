@@ -0,0 +1,66 @@
+#ifndef PDR_REASONS_H
+#define PDR_REASONS_H
+
+#include "data-structures.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pdr_search
+{
+  enum class ReasonMode
+  {
+    // only the greedy cover
+    GREEDY,
+    // greedy cover, then drop every literal that is not needed
+    MINIMAL,
+  };
+
+  // Computes the reason r at the end of extend.
+  //
+  // The candidate reasons are grouped in families (one for the noop and
+  // one for every operator). A family is satisfied if r contains one of
+  // its cubes, so r is a hitting set over the families. The generalizer
+  // keeps for every cube the number of its literals missing from r and
+  // for every family the number of its cubes contained in r, so adding or
+  // removing a literal only touches the cubes that contain it.
+  class ReasonGeneralizer
+  {
+  private:
+    ReasonMode mode;
+    std::vector<LiteralSet> cubes;
+    std::vector<int> cube_family;
+    std::vector<std::vector<int>> families;
+
+    // only valid during compute()
+    std::vector<int> missing;
+    std::vector<int> covered;
+    // cubes containing a literal, indexed by literal id
+    std::vector<std::vector<int>> occurrences;
+    std::vector<int> used_literal_ids;
+
+    static int get_literal_id(const Literal &l);
+    void add_to_reason(const Literal &l);
+    void remove_from_reason(const Literal &l);
+    // Returns true if every family with a cube containing l is still satisfied.
+    bool is_satisfied(const Literal &l) const;
+
+  public:
+    ReasonGeneralizer(ReasonMode mode);
+
+    // Removes all families.
+    void clear();
+    // Starts a new family of candidate reasons.
+    void add_family();
+    // Adds a candidate reason to the last family.
+    void add_cube(const LiteralSet &cube);
+    std::size_t get_num_families() const;
+    ReasonMode get_mode() const;
+
+    // Returns a reason that contains a cube of every family and
+    // removes all families.
+    LiteralSet compute();
+  };
+}
+
+#endif
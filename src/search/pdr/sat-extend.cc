@@ -0,0 +1,343 @@
+#include "sat-extend.h"
+
+#include "../utils/system.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+namespace pdr_search
+{
+  namespace
+  {
+    // Up to this size at-most-one constraints are encoded pairwise.
+    const std::size_t MAX_PAIRWISE = 5;
+  }
+
+  const int SATExtender::NONE;
+
+  SATExtender::SATExtender(const std::vector<LiteralSet> &pre,
+                           const std::vector<LiteralSet> &eff,
+                           const std::vector<std::vector<int>> &add,
+                           const std::vector<std::vector<int>> &del,
+                           bool minimize) :
+      preconditions(pre),
+      effects(eff),
+      adding(add),
+      deleting(del),
+      minimize_reasons(minimize),
+      operators(eff.size(), NONE),
+      operator_counter(NONE),
+      num_queries(0),
+      num_clauses(0)
+  {
+    std::size_t num_facts = FactIndex::get_num_facts();
+    // The current state variables come first, see get_reason.
+    for (std::size_t f = 0; f < num_facts; f++)
+    {
+      current.push_back(solver.new_variable());
+      assert(current[f] == static_cast<int>(f));
+    }
+    next.resize(num_facts, NONE);
+
+    // An operator is ruled out by the first assumption that falsifies one
+    // of its preconditions, so facts that are preconditions of many
+    // operators come first, like in the greedy cover of the reasons.
+    std::vector<std::size_t> num_preconditions(num_facts, 0);
+    for (const auto &pre : preconditions)
+    {
+      for (const auto &l : pre)
+      {
+        num_preconditions[l.get_fact_index()] += 1;
+      }
+    }
+    for (std::size_t f = 0; f < num_facts; f++)
+    {
+      assumption_order.push_back(f);
+    }
+    std::stable_sort(assumption_order.begin(), assumption_order.end(),
+                     [&num_preconditions](int f1, int f2) {
+                       return num_preconditions[f1] > num_preconditions[f2];
+                     });
+
+    // every variable has exactly one value
+    for (int var = 0; var < FactIndex::get_num_variables(); var++)
+    {
+      std::vector<int> values;
+      for (int value = 0; value < FactIndex::get_domain_size(var); value++)
+      {
+        values.push_back(SATSolver::make_literal(current[FactIndex::get_index(var, value)]));
+      }
+      solver.add_clause(values);
+      add_at_most_one(values);
+    }
+  }
+
+  void SATExtender::encode_variable(int var)
+  {
+    int dom_size = FactIndex::get_domain_size(var);
+    if (next[FactIndex::get_index(var, 0)] != NONE)
+    {
+      return;
+    }
+    std::vector<int> values;
+    for (int value = 0; value < dom_size; value++)
+    {
+      int f = FactIndex::get_index(var, value);
+      next[f] = solver.new_variable();
+      // Branch on the next state before the operators, the facts of the
+      // current state are tried first (see extend).
+      solver.bump_variable_activity(next[f]);
+      values.push_back(SATSolver::make_literal(next[f]));
+    }
+    solver.add_clause(values);
+    add_at_most_one(values);
+
+    for (int value = 0; value < dom_size; value++)
+    {
+      int f = FactIndex::get_index(var, value);
+      for (int a_i : adding[f])
+      {
+        encode_operator(a_i);
+        solver.add_clause({SATSolver::negate(operators[a_i]), SATSolver::make_literal(next[f])});
+      }
+    }
+
+    // frame axioms: a fact only changes if an operator changes it
+    for (int value = 0; value < dom_size; value++)
+    {
+      int f = FactIndex::get_index(var, value);
+      std::vector<int> added = {SATSolver::make_literal(next[f], true), SATSolver::make_literal(current[f])};
+      for (int a_i : adding[f])
+      {
+        added.push_back(operators[a_i]);
+      }
+      solver.add_clause(added);
+      std::vector<int> deleted = {SATSolver::make_literal(next[f]), SATSolver::make_literal(current[f], true)};
+      for (int a_i : deleting[f])
+      {
+        // an operator deleting f adds another value of var
+        assert(operators[a_i] != NONE);
+        deleted.push_back(operators[a_i]);
+      }
+      solver.add_clause(deleted);
+    }
+  }
+
+  void SATExtender::encode_operator(int a_i)
+  {
+    if (operators[a_i] != NONE)
+    {
+      return;
+    }
+    int a = SATSolver::make_literal(solver.new_variable());
+    operators[a_i] = a;
+    encoded_operators.push_back(a_i);
+    operator_counter = add_to_at_most_one(operator_counter, a);
+    for (const auto &l : preconditions[a_i])
+    {
+      solver.add_clause({SATSolver::negate(a), literal(current, l)});
+    }
+  }
+
+  int SATExtender::get_applied_operator()
+  {
+    for (int a_i : encoded_operators)
+    {
+      if (solver.get_model_value(operators[a_i] >> 1))
+      {
+        return a_i;
+      }
+    }
+    // without an operator the next state violates L like the current one
+    assert(false);
+    return NONE;
+  }
+
+  int SATExtender::literal(const std::vector<int> &facts, const Literal &l) const
+  {
+    assert(facts[l.get_fact_index()] != NONE);
+    return SATSolver::make_literal(facts[l.get_fact_index()], !l.is_positive());
+  }
+
+  void SATExtender::add_at_most_one(const std::vector<int> &literals)
+  {
+    if (literals.size() <= MAX_PAIRWISE)
+    {
+      for (std::size_t i = 0; i < literals.size(); i++)
+      {
+        for (std::size_t j = i + 1; j < literals.size(); j++)
+        {
+          solver.add_clause({SATSolver::negate(literals[i]), SATSolver::negate(literals[j])});
+        }
+      }
+      return;
+    }
+    int counter = NONE;
+    for (int l : literals)
+    {
+      counter = add_to_at_most_one(counter, l);
+    }
+  }
+
+  int SATExtender::add_to_at_most_one(int counter, int l)
+  {
+    // Sequential counter: the new counter holds if l or one of the
+    // literals before holds. It is not needed for a decision, it can be
+    // false as long as these literals are false.
+    if (counter != NONE)
+    {
+      solver.add_clause({SATSolver::negate(l), SATSolver::negate(counter)});
+    }
+    int next_counter = SATSolver::make_literal(solver.new_variable(false));
+    solver.add_clause({SATSolver::negate(l), next_counter});
+    if (counter != NONE)
+    {
+      solver.add_clause({SATSolver::negate(counter), next_counter});
+    }
+    return next_counter;
+  }
+
+  void SATExtender::add_layer_clauses(const Layer &L, std::vector<int> &assumptions)
+  {
+    for (const Layer *layer = &L; layer != nullptr; layer = layer->get_child().get())
+    {
+      auto it = activations.find(layer);
+      if (it == activations.end())
+      {
+        Activation activation;
+        activation.literal = SATSolver::make_literal(solver.new_variable());
+        activation.version = std::numeric_limits<std::size_t>::max();
+        it = activations.emplace(layer, std::move(activation)).first;
+      }
+      Activation &activation = it->second;
+      assumptions.push_back(activation.literal);
+      if (activation.version == layer->get_version())
+      {
+        continue;
+      }
+      const LayerDelta &delta = layer->get_delta();
+      for (std::size_t position = 0; position < delta.get_num_positions(); position++)
+      {
+        const LiteralSet *c = delta.get_clause(position);
+        if (c == nullptr || !activation.stamps.insert(delta.get_stamp(position)).second)
+        {
+          continue;
+        }
+        std::vector<int> clause = {SATSolver::negate(activation.literal)};
+        for (const auto &l : *c)
+        {
+          encode_variable(l.get_variable());
+          clause.push_back(literal(next, l));
+        }
+        solver.add_clause(clause);
+        num_clauses += 1;
+      }
+      activation.version = layer->get_version();
+    }
+  }
+
+  std::vector<int> SATExtender::get_reason(const std::vector<int> &layer_assumptions)
+  {
+    auto state_conflict = [this]() {
+      std::vector<int> r;
+      for (int l : solver.get_conflict())
+      {
+        // the variable of a current state fact is its fact index
+        if (static_cast<std::size_t>(l >> 1) < current.size())
+        {
+          r.push_back(l);
+        }
+      }
+      std::sort(r.begin(), r.end());
+      return r;
+    };
+
+    std::vector<int> r = state_conflict();
+    if (!minimize_reasons)
+    {
+      return r;
+    }
+    // Solving again with only the conflict often gives a smaller one.
+    while (true)
+    {
+      std::vector<int> assumptions = layer_assumptions;
+      assumptions.insert(assumptions.end(), r.begin(), r.end());
+      bool sat = solver.solve(assumptions);
+      utils::unused_variable(sat);
+      assert(!sat);
+      std::vector<int> smaller = state_conflict();
+      if (smaller.size() >= r.size())
+      {
+        break;
+      }
+      r = smaller;
+    }
+    return r;
+  }
+
+  std::pair<tl::optional<FullState>, LiteralSet> SATExtender::extend(const FullState &s, const Layer &L)
+  {
+    num_queries += 1;
+    std::vector<int> layer_assumptions;
+    add_layer_clauses(L, layer_assumptions);
+
+    // The negated facts that are false in s, a core over them gives a
+    // reason with negative literals like the explicit extend.
+    std::vector<int> state_assumptions;
+    for (int f : assumption_order)
+    {
+      const FactPair &fact = FactIndex::get_fact(f);
+      if (s[fact.var] != fact.value)
+      {
+        state_assumptions.push_back(SATSolver::make_literal(current[f], true));
+      }
+    }
+    for (std::size_t f = 0; f < next.size(); f++)
+    {
+      if (next[f] != NONE)
+      {
+        const FactPair &fact = FactIndex::get_fact(f);
+        solver.set_polarity(next[f], s[fact.var] == fact.value);
+      }
+    }
+
+    std::vector<int> assumptions = layer_assumptions;
+    assumptions.insert(assumptions.end(), state_assumptions.begin(), state_assumptions.end());
+    if (solver.solve(assumptions))
+    {
+      FullState t = s;
+      t.apply_cube(effects[get_applied_operator()]);
+      assert(t.models(L));
+      return std::make_pair(tl::optional<FullState>(std::move(t)), LiteralSet(SetType::CUBE));
+    }
+
+    LiteralSet r = LiteralSet(SetType::CUBE);
+    for (int l : get_reason(layer_assumptions))
+    {
+      const FactPair &fact = FactIndex::get_fact(l >> 1);
+      r.add_literal(Literal(fact.var, fact.value, false));
+    }
+    assert(s.models(r));
+    return std::make_pair(tl::optional<FullState>(), r);
+  }
+
+  void SATExtender::forget_layer_clauses()
+  {
+    for (const auto &activation : activations)
+    {
+      solver.add_clause({SATSolver::negate(activation.second.literal)});
+    }
+    activations.clear();
+    solver.remove_satisfied_clauses();
+  }
+
+  void SATExtender::print_statistics() const
+  {
+    std::cout << "SAT extend queries: " << num_queries << std::endl;
+    std::cout << "SAT extend layer clauses: " << num_clauses << std::endl;
+    std::cout << "SAT extend encoded operators: " << encoded_operators.size() << std::endl;
+    solver.print_statistics();
+  }
+}
@@ -0,0 +1,109 @@
+#ifndef PDR_SAT_EXTEND_H
+#define PDR_SAT_EXTEND_H
+
+#include "data-structures.h"
+#include "sat-solver.h"
+
+#include <optional.hh>
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace pdr_search
+{
+  // Answers the queries of extend with an incremental SAT solver.
+  //
+  // The transition relation is encoded over a copy of the facts for the
+  // current and for the next state and one variable per operator; without
+  // an operator the state stays the same. Only the variables that occur in
+  // a layer clause are encoded for the next state, together with the
+  // operators that change them: any other operator leaves every layer
+  // clause as it is, like the noop. So the encoding grows with the layers,
+  // a sequential counter that is extended with every new operator ensures
+  // that at most one operator is applied.
+  //
+  // The clauses of a layer delta are added over the next state facts
+  // guarded by an activation literal of the layer, a query for L assumes
+  // the activation literals of L and of all its children. The clauses are
+  // added when the version of a queried layer has changed, a clause that
+  // moves to a child layer is added again for the child.
+  //
+  // A query assumes the negation of the facts that are false in the state
+  // s. If no successor of s is in L, the reason consists of the negated
+  // facts in the final conflict.
+  class SATExtender
+  {
+  private:
+    struct Activation
+    {
+      int literal;
+      std::size_t version;
+      // stamps of the clauses of the delta that were added
+      std::unordered_set<std::size_t> stamps;
+    };
+
+    static const int NONE = -1;
+
+    const std::vector<LiteralSet> &preconditions;
+    const std::vector<LiteralSet> &effects;
+    const std::vector<std::vector<int>> &adding;
+    const std::vector<std::vector<int>> &deleting;
+    bool minimize_reasons;
+
+    SATSolver solver;
+    // The solver variable of every fact index in the current and in the
+    // next state, NONE in the next state if its variable is not encoded.
+    std::vector<int> current;
+    std::vector<int> next;
+    // The facts in the order in which they are assumed, see the constructor.
+    std::vector<int> assumption_order;
+    // The solver literal of every operator, NONE if it is not encoded.
+    std::vector<int> operators;
+    std::vector<int> encoded_operators;
+    // holds if one of the encoded operators is applied
+    int operator_counter;
+    std::unordered_map<const Layer *, Activation> activations;
+    std::size_t num_queries;
+    std::size_t num_clauses;
+
+    // The solver literal of l over the current or the next state facts.
+    int literal(const std::vector<int> &facts, const Literal &l) const;
+    void add_at_most_one(const std::vector<int> &literals);
+    // Adds l to the at-most-one constraint of counter, returns the new counter.
+    int add_to_at_most_one(int counter, int l);
+    // Encodes the variable in the next state and the operators changing it.
+    void encode_variable(int var);
+    void encode_operator(int a_i);
+    // Returns the operator applied in the last model.
+    int get_applied_operator();
+    void add_layer_clauses(const Layer &L, std::vector<int> &assumptions);
+    // Returns the negated facts that are needed for the conflict. If
+    // minimize_reasons is set, solves again with them until the conflict
+    // does not shrink anymore.
+    std::vector<int> get_reason(const std::vector<int> &layer_assumptions);
+
+  public:
+    // The operators are given as in PDRSearch: precondition and effect
+    // cubes, and for every fact the operators adding and deleting it.
+    // They are referenced, not copied.
+    SATExtender(const std::vector<LiteralSet> &preconditions,
+                const std::vector<LiteralSet> &effects,
+                const std::vector<std::vector<int>> &adding,
+                const std::vector<std::vector<int>> &deleting,
+                bool minimize_reasons);
+
+    // Returns (t, _) where t is a successor state of s in L
+    // or (nullopt, r) where r is a reason, like PDRSearch::extend.
+    std::pair<tl::optional<FullState>, LiteralSet> extend(const FullState &s, const Layer &L);
+    // Disables the layer clauses that were added so far and removes them
+    // from the solver. Needed once clauses were removed from the layers,
+    // the clauses that are still in the layers are added again.
+    void forget_layer_clauses();
+    void print_statistics() const;
+  };
+}
+
+#endif
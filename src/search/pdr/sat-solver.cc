@@ -0,0 +1,706 @@
+#include "sat-solver.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace pdr_search
+{
+  const signed char SATSolver::TRUE;
+  const signed char SATSolver::FALSE;
+  const signed char SATSolver::UNDEF;
+  const int SATSolver::NO_REASON;
+
+  namespace
+  {
+    const double VARIABLE_DECAY = 0.95;
+    const double CLAUSE_DECAY = 0.999;
+    const int RESTART_BASE = 100;
+
+    int variable_of(int literal)
+    {
+      return literal >> 1;
+    }
+
+    bool is_negated(int literal)
+    {
+      return literal & 1;
+    }
+
+    // The i-th element of the Luby sequence 1, 1, 2, 1, 1, 2, 4, ...
+    int luby(int i)
+    {
+      int size = 1;
+      int sequence = 0;
+      while (size < i + 1)
+      {
+        sequence += 1;
+        size = 2 * size + 1;
+      }
+      while (size - 1 != i)
+      {
+        size = (size - 1) >> 1;
+        sequence -= 1;
+        i = i % size;
+      }
+      return 1 << sequence;
+    }
+  }
+
+  SATSolver::SATSolver() :
+      ok(true),
+      propagation_head(0),
+      variable_increment(1),
+      clause_increment(1),
+      max_learned_clauses(1000),
+      num_solves(0),
+      num_conflicts(0),
+      num_decisions(0),
+      num_propagations(0)
+  {
+  }
+
+  signed char SATSolver::value(int literal) const
+  {
+    signed char v = assignment[variable_of(literal)];
+    return is_negated(literal) ? -v : v;
+  }
+
+  int SATSolver::decision_level() const
+  {
+    return trail_limits.size();
+  }
+
+  int SATSolver::new_variable(bool is_decision)
+  {
+    int var = assignment.size();
+    assignment.push_back(UNDEF);
+    level.push_back(0);
+    reason.push_back(NO_REASON);
+    activity.push_back(0);
+    polarity.push_back(false);
+    decision.push_back(is_decision);
+    seen.push_back(false);
+    heap_position.push_back(-1);
+    watches.emplace_back();
+    watches.emplace_back();
+    heap_insert(var);
+    return var;
+  }
+
+  void SATSolver::set_polarity(int var, bool v)
+  {
+    polarity[var] = !v;
+  }
+
+  void SATSolver::bump_variable_activity(int var)
+  {
+    bump_variable(var);
+  }
+
+  int SATSolver::get_num_variables() const
+  {
+    return assignment.size();
+  }
+
+  void SATSolver::enqueue(int literal, int from)
+  {
+    int var = variable_of(literal);
+    assert(assignment[var] == UNDEF);
+    assignment[var] = is_negated(literal) ? FALSE : TRUE;
+    level[var] = decision_level();
+    reason[var] = from;
+    trail.push_back(literal);
+  }
+
+  int SATSolver::propagate()
+  {
+    int conflicting = NO_REASON;
+    while (propagation_head < trail.size())
+    {
+      int p = trail[propagation_head++];
+      int false_literal = negate(p);
+      std::vector<Watcher> &ws = watches[p];
+      num_propagations += 1;
+      std::size_t i = 0;
+      std::size_t j = 0;
+      while (i < ws.size())
+      {
+        Watcher w = ws[i++];
+        if (value(w.blocker) == TRUE)
+        {
+          ws[j++] = w;
+          continue;
+        }
+        std::vector<int> &c = clauses[w.clause].literals;
+        // the false literal is kept at position 1
+        if (c[0] == false_literal)
+        {
+          std::swap(c[0], c[1]);
+        }
+        assert(c[1] == false_literal);
+        int first = c[0];
+        if (first != w.blocker && value(first) == TRUE)
+        {
+          ws[j++] = Watcher{w.clause, first};
+          continue;
+        }
+        bool found = false;
+        std::size_t &start = clauses[w.clause].search_start;
+        for (std::size_t n = 2; n < c.size(); n++)
+        {
+          std::size_t k = start + n - 2;
+          if (k >= c.size())
+          {
+            k -= c.size() - 2;
+          }
+          if (value(c[k]) != FALSE)
+          {
+            std::swap(c[1], c[k]);
+            watches[negate(c[1])].push_back(Watcher{w.clause, first});
+            start = k;
+            found = true;
+            break;
+          }
+        }
+        if (found)
+        {
+          continue;
+        }
+        ws[j++] = Watcher{w.clause, first};
+        if (value(first) == FALSE)
+        {
+          conflicting = w.clause;
+          propagation_head = trail.size();
+          while (i < ws.size())
+          {
+            ws[j++] = ws[i++];
+          }
+        }
+        else
+        {
+          enqueue(first, w.clause);
+        }
+      }
+      ws.resize(j);
+    }
+    return conflicting;
+  }
+
+  void SATSolver::cancel_until(int target)
+  {
+    if (decision_level() <= target)
+    {
+      return;
+    }
+    for (std::size_t i = trail.size(); i > trail_limits[target]; i--)
+    {
+      int var = variable_of(trail[i - 1]);
+      assignment[var] = UNDEF;
+      reason[var] = NO_REASON;
+      polarity[var] = is_negated(trail[i - 1]);
+      heap_insert(var);
+    }
+    trail.resize(trail_limits[target]);
+    trail_limits.resize(target);
+    propagation_head = trail.size();
+  }
+
+  void SATSolver::analyze(int conflicting, std::vector<int> &learned, int &backtrack_level)
+  {
+    learned.clear();
+    // placeholder for the asserting literal
+    learned.push_back(-1);
+    int open = 0;
+    int p = -1;
+    std::size_t index = trail.size();
+    do
+    {
+      assert(conflicting != NO_REASON);
+      Clause &c = clauses[conflicting];
+      if (c.learned)
+      {
+        bump_clause(conflicting);
+      }
+      for (std::size_t k = (p == -1 ? 0 : 1); k < c.literals.size(); k++)
+      {
+        int q = c.literals[k];
+        int var = variable_of(q);
+        if (!seen[var] && level[var] > 0)
+        {
+          bump_variable(var);
+          seen[var] = true;
+          if (level[var] >= decision_level())
+          {
+            open += 1;
+          }
+          else
+          {
+            learned.push_back(q);
+          }
+        }
+      }
+      // the next literal of the current level in the trail
+      while (!seen[variable_of(trail[--index])])
+      {
+      }
+      p = trail[index];
+      conflicting = reason[variable_of(p)];
+      seen[variable_of(p)] = false;
+      open -= 1;
+    } while (open > 0);
+    learned[0] = negate(p);
+
+    // Drop literals whose reason only contains literals of the clause.
+    std::vector<int> marked = learned;
+    std::size_t j = 1;
+    for (std::size_t i = 1; i < learned.size(); i++)
+    {
+      int var = variable_of(learned[i]);
+      bool redundant = reason[var] != NO_REASON;
+      if (redundant)
+      {
+        const std::vector<int> &r = clauses[reason[var]].literals;
+        for (std::size_t k = 1; k < r.size(); k++)
+        {
+          int other = variable_of(r[k]);
+          if (!seen[other] && level[other] > 0)
+          {
+            redundant = false;
+            break;
+          }
+        }
+      }
+      if (!redundant)
+      {
+        learned[j++] = learned[i];
+      }
+    }
+    learned.resize(j);
+    for (std::size_t i = 1; i < marked.size(); i++)
+    {
+      seen[variable_of(marked[i])] = false;
+    }
+
+    backtrack_level = 0;
+    if (learned.size() > 1)
+    {
+      // the literal of the highest level is watched next to the asserting one
+      std::size_t max_i = 1;
+      for (std::size_t i = 2; i < learned.size(); i++)
+      {
+        if (level[variable_of(learned[i])] > level[variable_of(learned[max_i])])
+        {
+          max_i = i;
+        }
+      }
+      std::swap(learned[1], learned[max_i]);
+      backtrack_level = level[variable_of(learned[1])];
+    }
+  }
+
+  void SATSolver::analyze_final(int p)
+  {
+    conflict.clear();
+    conflict.push_back(p);
+    if (decision_level() == 0)
+    {
+      return;
+    }
+    seen[variable_of(p)] = true;
+    for (std::size_t i = trail.size(); i > trail_limits[0]; i--)
+    {
+      int var = variable_of(trail[i - 1]);
+      if (!seen[var])
+      {
+        continue;
+      }
+      if (reason[var] == NO_REASON)
+      {
+        // all decisions below the current one are assumptions
+        assert(level[var] > 0);
+        conflict.push_back(trail[i - 1]);
+      }
+      else
+      {
+        const std::vector<int> &c = clauses[reason[var]].literals;
+        for (std::size_t k = 1; k < c.size(); k++)
+        {
+          if (level[variable_of(c[k])] > 0)
+          {
+            seen[variable_of(c[k])] = true;
+          }
+        }
+      }
+      seen[var] = false;
+    }
+    seen[variable_of(p)] = false;
+  }
+
+  int SATSolver::attach_clause(std::vector<int> literals, bool learned)
+  {
+    assert(literals.size() > 1);
+    int index;
+    if (free_clauses.empty())
+    {
+      index = clauses.size();
+      clauses.emplace_back();
+    }
+    else
+    {
+      index = free_clauses.back();
+      free_clauses.pop_back();
+    }
+    Clause &c = clauses[index];
+    c.literals = std::move(literals);
+    c.search_start = 2;
+    c.activity = 0;
+    c.learned = learned;
+    watches[negate(c.literals[0])].push_back(Watcher{index, c.literals[1]});
+    watches[negate(c.literals[1])].push_back(Watcher{index, c.literals[0]});
+    return index;
+  }
+
+  void SATSolver::remove_clause(int index)
+  {
+    Clause &c = clauses[index];
+    for (int i = 0; i < 2; i++)
+    {
+      std::vector<Watcher> &ws = watches[negate(c.literals[i])];
+      ws.erase(std::find_if(ws.begin(), ws.end(), [index](const Watcher &w) {
+        return w.clause == index;
+      }));
+    }
+    c.literals.clear();
+    c.literals.shrink_to_fit();
+    free_clauses.push_back(index);
+  }
+
+  bool SATSolver::is_locked(int index) const
+  {
+    int var = variable_of(clauses[index].literals[0]);
+    return reason[var] == index && value(clauses[index].literals[0]) == TRUE;
+  }
+
+  void SATSolver::reduce_learned_clauses()
+  {
+    std::sort(learned_clauses.begin(), learned_clauses.end(), [this](int a, int b) {
+      return clauses[a].activity < clauses[b].activity;
+    });
+    std::size_t j = 0;
+    std::size_t half = learned_clauses.size() / 2;
+    for (std::size_t i = 0; i < learned_clauses.size(); i++)
+    {
+      int index = learned_clauses[i];
+      if (i < half && clauses[index].literals.size() > 2 && !is_locked(index))
+      {
+        remove_clause(index);
+      }
+      else
+      {
+        learned_clauses[j++] = index;
+      }
+    }
+    learned_clauses.resize(j);
+  }
+
+  bool SATSolver::add_clause(std::vector<int> literals)
+  {
+    assert(decision_level() == 0);
+    if (!ok)
+    {
+      return false;
+    }
+    std::sort(literals.begin(), literals.end());
+    std::size_t j = 0;
+    int previous = -1;
+    for (int l : literals)
+    {
+      assert(variable_of(l) < get_num_variables());
+      if (value(l) == TRUE || l == negate(previous))
+      {
+        // satisfied or a tautology
+        return true;
+      }
+      if (value(l) != FALSE && l != previous)
+      {
+        literals[j++] = l;
+        previous = l;
+      }
+    }
+    literals.resize(j);
+
+    if (literals.empty())
+    {
+      ok = false;
+    }
+    else if (literals.size() == 1)
+    {
+      enqueue(literals[0], NO_REASON);
+      ok = propagate() == NO_REASON;
+    }
+    else
+    {
+      attach_clause(std::move(literals), false);
+    }
+    return ok;
+  }
+
+  void SATSolver::remove_satisfied_clauses()
+  {
+    assert(decision_level() == 0);
+    if (!ok)
+    {
+      return;
+    }
+    // The reasons of the assignments without decision are never used, see
+    // analyze, so their clauses can be removed as well.
+    for (int l : trail)
+    {
+      reason[variable_of(l)] = NO_REASON;
+    }
+    for (std::size_t index = 0; index < clauses.size(); index++)
+    {
+      const std::vector<int> &literals = clauses[index].literals;
+      // free clauses have no literals
+      if (std::any_of(literals.begin(), literals.end(), [this](int l) { return value(l) == TRUE; }))
+      {
+        remove_clause(index);
+      }
+    }
+    learned_clauses.erase(std::remove_if(learned_clauses.begin(), learned_clauses.end(), [this](int index) {
+      return clauses[index].literals.empty();
+    }), learned_clauses.end());
+  }
+
+  signed char SATSolver::search(int conflict_limit, const std::vector<int> &assumptions)
+  {
+    int conflicts = 0;
+    std::vector<int> learned;
+    while (true)
+    {
+      int conflicting = propagate();
+      if (conflicting != NO_REASON)
+      {
+        num_conflicts += 1;
+        conflicts += 1;
+        if (decision_level() == 0)
+        {
+          ok = false;
+          return FALSE;
+        }
+        int backtrack_level;
+        analyze(conflicting, learned, backtrack_level);
+        cancel_until(backtrack_level);
+        if (learned.size() == 1)
+        {
+          enqueue(learned[0], NO_REASON);
+        }
+        else
+        {
+          int index = attach_clause(learned, true);
+          learned_clauses.push_back(index);
+          bump_clause(index);
+          enqueue(clauses[index].literals[0], index);
+        }
+        variable_increment /= VARIABLE_DECAY;
+        clause_increment /= CLAUSE_DECAY;
+        continue;
+      }
+
+      if (conflicts >= conflict_limit)
+      {
+        cancel_until(0);
+        return UNDEF;
+      }
+      if (learned_clauses.size() >= max_learned_clauses + trail.size())
+      {
+        reduce_learned_clauses();
+      }
+
+      int next = -1;
+      while (decision_level() < static_cast<int>(assumptions.size()))
+      {
+        int p = assumptions[decision_level()];
+        if (value(p) == TRUE)
+        {
+          // dummy decision level
+          trail_limits.push_back(trail.size());
+        }
+        else if (value(p) == FALSE)
+        {
+          analyze_final(p);
+          return FALSE;
+        }
+        else
+        {
+          next = p;
+          break;
+        }
+      }
+
+      if (next == -1)
+      {
+        num_decisions += 1;
+        int var = heap_pop();
+        while (var != -1 && assignment[var] != UNDEF)
+        {
+          var = heap_pop();
+        }
+        if (var == -1)
+        {
+          return TRUE;
+        }
+        next = make_literal(var, polarity[var]);
+      }
+      trail_limits.push_back(trail.size());
+      enqueue(next, NO_REASON);
+    }
+  }
+
+  bool SATSolver::solve(const std::vector<int> &assumptions)
+  {
+    num_solves += 1;
+    conflict.clear();
+    if (!ok)
+    {
+      return false;
+    }
+    max_learned_clauses = std::max(max_learned_clauses, clauses.size() / 3.0);
+    signed char status = UNDEF;
+    for (int restarts = 0; status == UNDEF; restarts++)
+    {
+      if (restarts > 0)
+      {
+        max_learned_clauses *= 1.05;
+      }
+      status = search(luby(restarts) * RESTART_BASE, assumptions);
+    }
+    if (status == TRUE)
+    {
+      model = assignment;
+    }
+    cancel_until(0);
+    return status == TRUE;
+  }
+
+  bool SATSolver::get_model_value(int var) const
+  {
+    assert(model[var] != UNDEF);
+    return model[var] == TRUE;
+  }
+
+  const std::vector<int> &SATSolver::get_conflict() const
+  {
+    return conflict;
+  }
+
+  void SATSolver::bump_variable(int var)
+  {
+    activity[var] += variable_increment;
+    if (activity[var] > 1e100)
+    {
+      for (double &a : activity)
+      {
+        a *= 1e-100;
+      }
+      variable_increment *= 1e-100;
+    }
+    if (heap_position[var] != -1)
+    {
+      heap_up(heap_position[var]);
+    }
+  }
+
+  void SATSolver::bump_clause(int index)
+  {
+    clauses[index].activity += clause_increment;
+    if (clauses[index].activity > 1e20)
+    {
+      for (int learned : learned_clauses)
+      {
+        clauses[learned].activity *= 1e-20;
+      }
+      clause_increment *= 1e-20;
+    }
+  }
+
+  void SATSolver::heap_insert(int var)
+  {
+    if (heap_position[var] != -1 || !decision[var])
+    {
+      return;
+    }
+    heap_position[var] = heap.size();
+    heap.push_back(var);
+    heap_up(heap.size() - 1);
+  }
+
+  void SATSolver::heap_up(std::size_t position)
+  {
+    int var = heap[position];
+    while (position > 0)
+    {
+      std::size_t parent = (position - 1) / 2;
+      if (activity[heap[parent]] >= activity[var])
+      {
+        break;
+      }
+      heap[position] = heap[parent];
+      heap_position[heap[position]] = position;
+      position = parent;
+    }
+    heap[position] = var;
+    heap_position[var] = position;
+  }
+
+  void SATSolver::heap_down(std::size_t position)
+  {
+    int var = heap[position];
+    while (2 * position + 1 < heap.size())
+    {
+      std::size_t child = 2 * position + 1;
+      if (child + 1 < heap.size() && activity[heap[child + 1]] > activity[heap[child]])
+      {
+        child += 1;
+      }
+      if (activity[heap[child]] <= activity[var])
+      {
+        break;
+      }
+      heap[position] = heap[child];
+      heap_position[heap[position]] = position;
+      position = child;
+    }
+    heap[position] = var;
+    heap_position[var] = position;
+  }
+
+  int SATSolver::heap_pop()
+  {
+    if (heap.empty())
+    {
+      return -1;
+    }
+    int var = heap[0];
+    heap_position[var] = -1;
+    int last = heap.back();
+    heap.pop_back();
+    if (!heap.empty())
+    {
+      heap[0] = last;
+      heap_position[last] = 0;
+      heap_down(0);
+    }
+    return var;
+  }
+
+  void SATSolver::print_statistics() const
+  {
+    std::cout << "SAT solver calls: " << num_solves << std::endl;
+    std::cout << "SAT solver conflicts: " << num_conflicts << std::endl;
+    std::cout << "SAT solver decisions: " << num_decisions << std::endl;
+    std::cout << "SAT solver propagations: " << num_propagations << std::endl;
+    std::cout << "SAT solver learned clauses: " << learned_clauses.size() << std::endl;
+  }
+}
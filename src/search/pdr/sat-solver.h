@@ -0,0 +1,146 @@
+#ifndef PDR_SAT_SOLVER_H
+#define PDR_SAT_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace pdr_search
+{
+  // A small incremental CDCL SAT solver in the style of MiniSat: two
+  // watched literals, first UIP learning, VSIDS with phase saving and
+  // Luby restarts.
+  //
+  // Clauses can be added between calls to solve and are only removed once
+  // they are satisfied, so the learned clauses stay valid. Each call takes a set of assumptions;
+  // if they are inconsistent with the clauses, get_conflict returns the
+  // assumptions that were needed to derive the conflict.
+  //
+  // A literal of variable v is 2 * v if it is positive and 2 * v + 1 if
+  // it is negated.
+  class SATSolver
+  {
+  private:
+    struct Clause
+    {
+      std::vector<int> literals;
+      // Where the search for a new watched literal continues, so long
+      // clauses are not scanned from the start every time.
+      std::size_t search_start;
+      double activity;
+      bool learned;
+    };
+
+    struct Watcher
+    {
+      int clause;
+      // A literal of the clause, if it is true the clause need not be visited.
+      int blocker;
+    };
+
+    // Values of variables and literals
+    static const signed char TRUE = 1;
+    static const signed char FALSE = -1;
+    static const signed char UNDEF = 0;
+    static const int NO_REASON = -1;
+
+    // false once the clauses are unsatisfiable without assumptions
+    bool ok;
+    std::vector<Clause> clauses;
+    // Indices of clauses that were deleted and can be reused.
+    std::vector<int> free_clauses;
+    std::vector<int> learned_clauses;
+    // For every literal the clauses in which its negation is watched,
+    // i.e. that have to be visited once the literal becomes true.
+    std::vector<std::vector<Watcher>> watches;
+
+    std::vector<signed char> assignment;
+    std::vector<int> level;
+    std::vector<int> reason;
+    std::vector<int> trail;
+    // The position in the trail where each decision level starts.
+    std::vector<std::size_t> trail_limits;
+    std::size_t propagation_head;
+
+    std::vector<double> activity;
+    double variable_increment;
+    double clause_increment;
+    std::vector<bool> polarity;
+    std::vector<bool> decision;
+    // Binary max heap of the unassigned variables by activity, for each
+    // variable its position in the heap or -1.
+    std::vector<int> heap;
+    std::vector<int> heap_position;
+
+    std::vector<signed char> model;
+    std::vector<int> conflict;
+    std::vector<bool> seen;
+    double max_learned_clauses;
+
+    std::size_t num_solves;
+    std::size_t num_conflicts;
+    std::size_t num_decisions;
+    std::size_t num_propagations;
+
+    signed char value(int literal) const;
+    int decision_level() const;
+    void enqueue(int literal, int from);
+    // Returns the conflicting clause, or NO_REASON.
+    int propagate();
+    void cancel_until(int level);
+    void analyze(int conflicting, std::vector<int> &learned, int &backtrack_level);
+    // Computes the assumptions that imply the negation of the assumption p.
+    void analyze_final(int p);
+    int attach_clause(std::vector<int> literals, bool learned);
+    void remove_clause(int clause);
+    bool is_locked(int clause) const;
+    void reduce_learned_clauses();
+    // Returns TRUE, FALSE or UNDEF if the conflict limit was reached.
+    signed char search(int conflict_limit, const std::vector<int> &assumptions);
+
+    void bump_variable(int var);
+    void bump_clause(int clause);
+    void heap_insert(int var);
+    void heap_up(std::size_t position);
+    void heap_down(std::size_t position);
+    int heap_pop();
+
+  public:
+    SATSolver();
+
+    static int make_literal(int var, bool negated = false)
+    {
+      return 2 * var + (negated ? 1 : 0);
+    }
+
+    static int negate(int literal)
+    {
+      return literal ^ 1;
+    }
+
+    // The solver only branches on decision variables. The others have to
+    // be assigned by propagation once all decision variables are, the
+    // solver may return a model in which they are unassigned otherwise.
+    int new_variable(bool is_decision = true);
+    // The value tried first when branching on the variable, until it
+    // is assigned the other way by propagation (phase saving).
+    void set_polarity(int var, bool value);
+    // Branch on the variable before the variables that were not bumped.
+    void bump_variable_activity(int var);
+    int get_num_variables() const;
+    // Returns false if the clauses are unsatisfiable without assumptions.
+    bool add_clause(std::vector<int> literals);
+    // Removes the clauses that are satisfied without assumptions, e.g.
+    // clauses guarded by a literal that was disabled with a unit clause.
+    void remove_satisfied_clauses();
+    // Returns true if the clauses are satisfiable under the assumptions.
+    bool solve(const std::vector<int> &assumptions);
+    // The value of a variable in the model of the last satisfiable call.
+    bool get_model_value(int var) const;
+    // The assumptions of the last unsatisfiable call that imply the
+    // conflict, empty if the clauses are unsatisfiable by themselves.
+    const std::vector<int> &get_conflict() const;
+    void print_statistics() const;
+  };
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include "shared-clauses.h"
+
+namespace pdr_search
+{
+  const int SharedClauses::NONE;
+
+  SharedClauses::SharedClauses() : winner(NONE), stopped(false)
+  {
+  }
+
+  void SharedClauses::publish(int search, const std::vector<std::pair<int, LiteralSet>> &learned)
+  {
+    if (learned.empty())
+    {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &c : learned)
+    {
+      clauses.push_back(SharedClause{search, c.first, c.second});
+    }
+  }
+
+  std::vector<std::pair<int, LiteralSet>> SharedClauses::collect(int search, std::size_t &position) const
+  {
+    std::vector<std::pair<int, LiteralSet>> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (; position < clauses.size(); position++)
+    {
+      const SharedClause &c = clauses[position];
+      if (c.search != search)
+      {
+        result.emplace_back(c.layer, c.clause);
+      }
+    }
+    return result;
+  }
+
+  std::size_t SharedClauses::size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return clauses.size();
+  }
+
+  bool SharedClauses::finish(int search)
+  {
+    int expected = NONE;
+    return winner.compare_exchange_strong(expected, search);
+  }
+
+  int SharedClauses::get_winner() const
+  {
+    return winner.load();
+  }
+
+  void SharedClauses::stop()
+  {
+    stopped.store(true);
+  }
+
+  bool SharedClauses::is_stopped() const
+  {
+    return stopped.load() || winner.load() != NONE;
+  }
+}
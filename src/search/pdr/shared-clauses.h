@@ -0,0 +1,62 @@
+#ifndef PDR_SHARED_CLAUSES_H
+#define PDR_SHARED_CLAUSES_H
+
+#include "data-structures.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace pdr_search
+{
+  // The clauses learned by the searches of a portfolio that run in
+  // parallel on the same task. A clause of layer i only excludes states
+  // that can not reach the goal in i steps, so it holds for the layer i of
+  // every search. Whether a search can use it without breaking the
+  // relative induction of its layers is up to the search (see
+  // PDRSearch::import_shared_clauses).
+  //
+  // Clauses are only appended, every search reads the clauses published
+  // since its last visit. All methods are thread-safe.
+  class SharedClauses
+  {
+  private:
+    struct SharedClause
+    {
+      int search;
+      int layer;
+      LiteralSet clause;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<SharedClause> clauses;
+    std::atomic<int> winner;
+    std::atomic<bool> stopped;
+
+  public:
+    static const int NONE = -1;
+
+    SharedClauses();
+
+    // Publishes the clauses (layer, clause) learned by the given search.
+    void publish(int search, const std::vector<std::pair<int, LiteralSet>> &learned);
+    // Returns the clauses of the other searches that were published after
+    // position and moves position to the end.
+    std::vector<std::pair<int, LiteralSet>> collect(int search, std::size_t &position) const;
+    std::size_t size() const;
+
+    // Marks the search as finished. The first one wins, returns true if
+    // it is the given search.
+    bool finish(int search);
+    // Returns the search that finished first, or NONE.
+    int get_winner() const;
+    // Tells the searches to stop, e.g. once the portfolio ran out of time.
+    void stop();
+    // Returns true once a search finished or the portfolio was stopped.
+    bool is_stopped() const;
+  };
+}
+
+#endif
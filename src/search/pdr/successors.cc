@@ -0,0 +1,75 @@
+#include "successors.h"
+
+#include "../evaluation_context.h"
+#include "../evaluation_result.h"
+#include "../evaluator.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace pdr_search
+{
+  SuccessorEvaluator::SuccessorEvaluator(std::shared_ptr<Evaluator> e, const TaskProxy &t,
+                                         const int_packer::IntPacker &p, bool c) :
+      evaluator(e),
+      task_proxy(t),
+      packer(p),
+      use_cache(c),
+      num_evaluations(0),
+      num_cache_hits(0)
+  {
+  }
+
+  int SuccessorEvaluator::evaluate(const FullState &s)
+  {
+    std::vector<int_packer::IntPacker::Bin> packed;
+    if (use_cache)
+    {
+      packed = pack_state(packer, s);
+      auto it = cache.find(packed);
+      if (it != cache.end())
+      {
+        num_cache_hits += 1;
+        return it->second;
+      }
+    }
+
+    std::vector<int> values(s.size());
+    for (std::size_t var = 0; var < s.size(); var++)
+    {
+      values[var] = s[var];
+    }
+    EvaluationContext context(task_proxy.create_state(std::move(values)));
+    int value = context.get_evaluator_value_or_infinity(evaluator.get());
+    num_evaluations += 1;
+
+    if (use_cache)
+    {
+      cache.insert(std::make_pair(std::move(packed), value));
+    }
+    return value;
+  }
+
+  std::size_t SuccessorEvaluator::select(const std::vector<FullState> &candidates)
+  {
+    assert(!candidates.empty());
+    std::size_t best = 0;
+    int best_value = evaluate(candidates[0]);
+    for (std::size_t c = 1; c < candidates.size(); c++)
+    {
+      int value = evaluate(candidates[c]);
+      if (value < best_value)
+      {
+        best = c;
+        best_value = value;
+      }
+    }
+    return best;
+  }
+
+  void SuccessorEvaluator::print_statistics() const
+  {
+    std::cout << "Successor evaluations: " << num_evaluations << std::endl;
+    std::cout << "Successor evaluation cache hits: " << num_cache_hits << std::endl;
+  }
+}
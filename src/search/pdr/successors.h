@@ -0,0 +1,46 @@
+#ifndef PDR_SUCCESSORS_H
+#define PDR_SUCCESSORS_H
+
+#include "data-structures.h"
+
+#include "../task_proxy.h"
+#include "../algorithms/int_packer.h"
+#include "../utils/hash.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class Evaluator;
+
+namespace pdr_search
+{
+  // Evaluates the successor candidates of extend with an evaluator.
+  //
+  // The states of PDR are not registered, so the evaluator itself can not
+  // cache its values. Instead the values are cached here per (packed) state.
+  class SuccessorEvaluator
+  {
+  private:
+    std::shared_ptr<Evaluator> evaluator;
+    TaskProxy task_proxy;
+    const int_packer::IntPacker &packer;
+    bool use_cache;
+    utils::HashMap<std::vector<int_packer::IntPacker::Bin>, int> cache;
+    std::size_t num_evaluations;
+    std::size_t num_cache_hits;
+
+  public:
+    SuccessorEvaluator(std::shared_ptr<Evaluator> evaluator, const TaskProxy &task_proxy,
+                       const int_packer::IntPacker &packer, bool use_cache);
+
+    // Returns the value of s, EvaluationResult::INFTY for dead ends.
+    int evaluate(const FullState &s);
+    // Returns the index of the candidate with the smallest value,
+    // the first one on ties.
+    std::size_t select(const std::vector<FullState> &candidates);
+    void print_statistics() const;
+  };
+}
+
+#endif
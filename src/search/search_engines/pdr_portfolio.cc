@@ -0,0 +1,104 @@
+#include "pdr_portfolio.h"
+
+#include "../option_parser.h"
+
+#include "../utils/countdown_timer.h"
+#include "../utils/system.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace pdr_search
+{
+    PDRPortfolio::PDRPortfolio(const Options &opts) : SearchEngine(opts),
+        shared_clauses(std::make_shared<SharedClauses>())
+    {
+        bool exchange = opts.get<bool>("share-clauses");
+        for (const auto &engine : opts.get_list<std::shared_ptr<SearchEngine>>("searches"))
+        {
+            std::shared_ptr<PDRSearch> search = std::dynamic_pointer_cast<PDRSearch>(engine);
+            if (!search)
+            {
+                std::cerr << "pdr-portfolio can only run pdr searches" << std::endl;
+                utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+            }
+            // Backward layers hold in other states than forward ones, only
+            // forward searches exchange clauses.
+            search->join_portfolio(shared_clauses, searches.size(), exchange && !search->is_backward());
+            searches.push_back(search);
+        }
+    }
+
+    SearchStatus PDRPortfolio::step()
+    {
+        utils::CountdownTimer timer(max_time);
+        // Serially, the threads must not write to the shared log.
+        for (const auto &search : searches)
+        {
+            search->initialize();
+        }
+        std::atomic<std::size_t> num_running(searches.size());
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < searches.size(); i++)
+        {
+            threads.push_back(std::thread([this, i, &num_running]()
+            {
+                SearchStatus status = searches[i]->search_in_portfolio();
+                if (status == SOLVED || status == FAILED)
+                {
+                    shared_clauses->finish(i);
+                }
+                num_running -= 1;
+            }));
+        }
+        // SearchEngine::search only checks max_time after this step.
+        while (num_running > 0)
+        {
+            if (timer.is_expired())
+            {
+                std::cout << "Time limit of the portfolio reached" << std::endl;
+                shared_clauses->stop();
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        int winner = shared_clauses->get_winner();
+        if (winner == SharedClauses::NONE)
+        {
+            std::cout << "No search of the portfolio has finished" << std::endl;
+            return TIMEOUT;
+        }
+        std::cout << "Search " << winner << " of the portfolio finished first" << std::endl;
+        if (searches[winner]->found_solution())
+        {
+            set_plan(searches[winner]->get_plan());
+            return SOLVED;
+        }
+        return FAILED;
+    }
+
+    void PDRPortfolio::print_statistics() const
+    {
+        for (std::size_t i = 0; i < searches.size(); i++)
+        {
+            std::cout << "Statistics of search " << i << " of the portfolio:" << std::endl;
+            searches[i]->print_statistics();
+        }
+        std::cout << "Shared clauses: " << shared_clauses->size() << std::endl;
+        statistics.print_detailed_statistics();
+    }
+
+    void add_portfolio_options_to_parser(OptionParser &parser)
+    {
+        parser.add_list_option<std::shared_ptr<SearchEngine>>("searches", "pdr searches that are run in parallel");
+        parser.add_option<bool>("share-clauses", "let the searches exchange the clauses they learn", "true");
+        SearchEngine::add_options_to_parser(parser);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef SEARCH_ENGINES_PDR_PORTFOLIO_H
+#define SEARCH_ENGINES_PDR_PORTFOLIO_H
+
+#include "../search_engine.h"
+
+#include "pdr_search.h"
+
+#include "../pdr/shared-clauses.h"
+
+#include <memory>
+#include <vector>
+
+namespace options
+{
+    class OptionParser;
+    class Options;
+}
+
+namespace pdr_search
+{
+    // Runs several PDR searches on the same task, each in its own thread,
+    // until the first one solves the task or proves it unsolvable. If
+    // share-clauses is set, the searches exchange the clauses they learn
+    // (see SharedClauses).
+    class PDRPortfolio : public SearchEngine
+    {
+        std::vector<std::shared_ptr<PDRSearch>> searches;
+        std::shared_ptr<SharedClauses> shared_clauses;
+
+    protected:
+        virtual SearchStatus step() override;
+
+    public:
+        PDRPortfolio(const options::Options &opts);
+
+        virtual void print_statistics() const override;
+    };
+
+    extern void add_portfolio_options_to_parser(options::OptionParser &parser);
+}
+
+#endif
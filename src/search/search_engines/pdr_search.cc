@@ -1,8 +1,13 @@
 #include "pdr_search.h"
 
+#include "../evaluator.h"
 #include "../option_parser.h"
 
+#include "../utils/countdown_timer.h"
 #include "../utils/logging.h"
+#include "../utils/memory.h"
+#include "../utils/system.h"
+#include "../task_utils/task_properties.h"
 #include "../plan_manager.h"
 
 #include "../pdr/pattern-database.h"
@@ -11,70 +16,171 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <optional.hh>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
+#include <limits>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <vector>
 #include <chrono>
+#include <thread>
 
 
 namespace pdr_search
 {
+    namespace
+    {
+        // Backward, an operator is split into at most this many operators,
+        // see add_backward_operators.
+        const std::size_t MAX_BACKWARD_SPLITS = 64;
+
+        // The searches of a portfolio print from their own threads.
+        std::mutex progress_mutex;
+
+        // The cube that sets the variable of the positive literal l to its value.
+        LiteralSet assignment_cube(const Literal &l)
+        {
+            assert(l.is_positive());
+            LiteralSet c = LiteralSet(l, SetType::CUBE);
+            int dom_size = FactIndex::get_domain_size(l.get_variable());
+            for (int value = 0; value < dom_size; value++)
+            {
+                if (value != l.get_value())
+                {
+                    c.add_literal(Literal(l.get_variable(), value, false));
+                }
+            }
+            return c;
+        }
+    }
+
+    std::vector<int> PDRSearch::collect_operators(const std::unordered_set<const LiteralSet *> &clauses,
+                                                  ExtendWorkspace &workspace) const
+    {
+        std::vector<int> ops;
+        std::vector<std::size_t> &operator_marks = workspace.operator_marks;
+        std::size_t operator_mark = ++workspace.operator_mark;
+        for (const LiteralSet *c : clauses)
+        {
+            for (const auto &l : *c)
+            {
+                // a violated positive literal becomes true if the fact is added,
+                // a violated negative literal if the fact is deleted.
+                const auto &candidates = l.is_positive() ? A_adding[l.get_fact_index()] : A_deleting[l.get_fact_index()];
+                for (int a_i : candidates)
+                {
+                    if (operator_marks[a_i] != operator_mark)
+                    {
+                        operator_marks[a_i] = operator_mark;
+                        ops.push_back(a_i);
+                    }
+                }
+            }
+        }
+        std::sort(ops.begin(), ops.end());
+        return ops;
+    }
 
-    std::pair<LiteralSet, bool> PDRSearch::extend(const LiteralSet &s, const Layer &L)
+    std::pair<tl::optional<FullState>, LiteralSet> PDRSearch::extend(const FullState &s, const Layer &L)
     {
         extend_time.resume();
-        assert(!s.models(L));
+        std::pair<tl::optional<FullState>, LiteralSet> result =
+            sat_extender ? sat_extender->extend(s, L) : extend_explicit(s, L, workspaces[0]);
+        if (clause_database)
+        {
+            clause_database->bump(L, workspaces[0].blocking);
+        }
+        extend_time.stop();
+        return result;
+    }
 
-        auto A = this->task_proxy.get_operators();
+    std::pair<tl::optional<FullState>, LiteralSet> PDRSearch::extend_explicit(const FullState &s, const Layer &L,
+                                                                              ExtendWorkspace &workspace) const
+    {
+        assert(!s.models(L));
+        ReasonGeneralizer &reasons = workspace.reasons;
 
-        SetOfLiteralSets Ls = SetOfLiteralSets(SetType::CLAUSE);
-        SetOfLiteralSets Rnoop = SetOfLiteralSets(SetType::CUBE);
+        // Clauses of L that are violated by s. The pointers refer to the
+        // clauses stored in the layer deltas, so they can be matched with
+        // the occurrence lists of the layers.
+        std::unordered_set<const LiteralSet *> Ls;
 
-        std::unordered_set<SetOfLiteralSets, SetOfLiteralSetsHash> Reasons;
-        auto sets = L.get_sets();
-        for (auto c = sets->begin(); c != sets->end(); ++c) 
-        { 
-            if (!s.models(*c))
+        // The families of a previous call are left over if it found a successor.
+        reasons.clear();
+        // Rnoop
+        reasons.add_family();
+        for (const auto &c : L)
+        {
+            if (!s.models(c))
             {
-                Ls.add_set(*c);
-                Rnoop.add_set(c->invert());
+                Ls.insert(&c);
+                reasons.add_cube(c.invert());
             }
         }
 
-        assert(Rnoop.size() > 0);
-        Reasons.insert(Rnoop);
+        assert(Ls.size() > 0);
 
-        for (size_t a_i = 0; a_i < A.size(); a_i++)
+        // Successors in L, only collected if they are chosen by an evaluator.
+        std::vector<FullState> successors;
+
+        // An operator that makes no clause of Ls true has Ls ⊆ Lt,
+        // so it neither gives a successor nor a reason.
+        for (int a_i : collect_operators(Ls, workspace))
         {
-            auto pre = from_precondition(A[a_i].get_preconditions());
+            const LiteralSet &pre = A_precondition[a_i];
 
             auto pre_sa = LiteralSet(SetType::CLAUSE);
-            for (const auto &l : pre.get_literals())
+            for (const auto &l : pre)
             {
-                if (!s.models(LiteralSet(l, SetType::CLAUSE)))
+                if (!s.models(l))
                 {
                     pre_sa.add_literal(l);
                 }
             }
             assert(pre_sa.is_subset_eq_of(pre));
 
-            LiteralSet &eff_a = A_effect[a_i]; 
-            LiteralSet t = LiteralSet(s);
-            for (const auto &l : eff_a.get_literals())
-            {
-                // apply eff_a to t
-                t.apply_literal(l);
-            }
+            const LiteralSet &eff_a = A_effect[a_i];
+            FullState t = s;
+            // apply eff_a to t
+            t.apply_cube(eff_a);
 
-            SetOfLiteralSets Lt = SetOfLiteralSets(SetType::CLAUSE);
-            for (auto c = sets->begin(); c != sets->end(); ++c)
+            // t only differs from s in the variables changed by eff_a,
+            // so only clauses over these variables have to be rechecked.
+            std::unordered_set<const LiteralSet *> Lt = Ls;
+            bool Ls_subset_of_Lt = true;
+            for (const auto &l : eff_a)
             {
-                if (!t.models(*c))
+                if (!l.is_positive() || s[l.get_variable()] == l.get_value())
                 {
-                    Lt.add_set(*c);
+                    continue;
+                }
+                for (const Layer *layer = &L; layer != nullptr; layer = layer->get_child().get())
+                {
+                    const LayerDelta &delta = layer->get_delta();
+                    for (std::size_t position : delta.get_occurrences(l.get_variable()))
+                    {
+                        const LiteralSet *c = delta.get_clause(position);
+                        if (c == nullptr)
+                        {
+                            continue;
+                        }
+                        if (!t.models(*c))
+                        {
+                            Lt.insert(c);
+                        }
+                        else if (Lt.erase(c) > 0)
+                        {
+                            // c is violated by s but not by t
+                            Ls_subset_of_Lt = false;
+                        }
+                    }
                 }
             }
 
@@ -83,102 +189,130 @@ namespace pdr_search
                 // output condition of successor
                 assert(t.models(L));
 
-                this->extend_time.stop();
-                return std::pair<LiteralSet, bool>(t, true);
+                if (successor_evaluator)
+                {
+                    successors.push_back(std::move(t));
+                    continue;
+                }
+                return std::make_pair(tl::optional<FullState>(t), LiteralSet(SetType::CUBE));
             }
 
-            else if (Ls.is_subset_eq_of(Lt))
+            else if (Ls_subset_of_Lt || !successors.empty())
             {
+                // the reason is not needed once there is a successor
                 continue;
             }
             else
             {
                 // Comment: In the pseudocode, the arrow should be pointing left (Suda)
-                SetOfLiteralSets Lt0 = SetOfLiteralSets(SetType::CLAUSE);
-                for (const auto &c : Lt.get_sets())
-                {
-                    if (c.set_intersect_size(pre_sa) == 0)
-                    {
-                        Lt0.add_set(c);
-                    }
-                }
-
-                SetOfLiteralSets R_a = SetOfLiteralSets(SetType::CUBE);
-                for (const auto &l : pre_sa.get_literals())
+                // R_a consists of the negated missing preconditions and
+                // the cubes of the clauses in Lt0 that eff_a does not touch.
+                reasons.add_family();
+                for (const auto &l : pre_sa)
                 {
-                    R_a.add_set(LiteralSet(l.invert(), SetType::CUBE));
+                    reasons.add_cube(LiteralSet(l.invert(), SetType::CUBE));
                 }
 
-                for (const auto &c : Lt0.get_sets())
+                for (const LiteralSet *c : Lt)
                 {
+                    if (c->set_intersect_size(pre_sa) != 0)
+                    {
+                        continue;
+                    }
+                    if (clause_database)
+                    {
+                        // c keeps the successor of a out of L
+                        workspace.blocking.push_back(c);
+                    }
                     LiteralSet ls = LiteralSet(SetType::CUBE);
-                    for (const auto &l : c.get_literals())
+                    for (const auto &l : *c)
                     {
                         if (!eff_a.contains_literal(l.invert()))
                         {
                             ls.add_literal(l.invert());
                         }
                     }
-                    R_a.add_set(ls);
+                    reasons.add_cube(ls);
                 }
-
-                Reasons.insert(R_a);
             }
         }
 
-        LiteralSet r = LiteralSet(SetType::CUBE);
+        if (!successors.empty())
+        {
+            std::size_t best = successor_evaluator->select(successors);
+            return std::make_pair(tl::optional<FullState>(std::move(successors[best])), LiteralSet(SetType::CUBE));
+        }
+
+        LiteralSet r = reasons.compute();
 
-        std::vector<SetOfLiteralSets> R = std::vector<SetOfLiteralSets>(Reasons.begin(), Reasons.end());
-        std::sort(R.begin(), R.end(), [](const SetOfLiteralSets &f, const SetOfLiteralSets &l)
-                  { return f.size() < l.size(); });
+        assert(r.size() > 0);
+        
+        // output condition of reason.
+        assert(s.models(r));
+        return std::make_pair(tl::optional<FullState>(), r);
+    }
 
-        int i = 0;
-        for (const auto &Ra : R)
+    void PDRSearch::extend_batch(int si, int i, std::unordered_map<int, Extension> &extensions)
+    {
+        ObligationManager &Q = this->obligations;
+        std::shared_ptr<Layer> L = get_layer(i - 1);
+        // A few obligations per thread balance the load, more would mostly
+        // be extended into a layer that has changed until their turn.
+        std::size_t max_size = 4 * extend_threads;
+        std::vector<int> batch = {si};
+        if (!Q.empty() && Q.get_min_priority() == i)
         {
-            LiteralSet ra = LiteralSet(SetType::CUBE);
-            size_t ra_size = 0;
-            for (const auto &ra_cur : Ra.get_sets())
+            // obligations in L are continued below, see step
+            bool weakened = clause_database && clause_database->is_weakened(i - 1);
+            for (int ob : Q.peek(max_size - 1))
             {
-                if (ra_size == 0 || ra_size > r.set_union(ra_cur).size())
+                if (extensions.count(ob) == 0 && !(weakened && Q.get(ob).get_state().models(*L)))
                 {
-                    ra = ra_cur;
-                    ra_size = r.set_union(ra).size();
+                    batch.push_back(ob);
                 }
             }
-            r = r.set_union(ra);
-            i += 1;
         }
+        std::vector<Extension> results(batch.size());
 
-        auto r_literals = r.get_literals();
-        for (const auto &l : r_literals) {
-            auto ls = LiteralSet(SetType::CUBE);
-            ls.add_literal(l);
-            auto r_minus_l = r.set_minus(ls);
-            bool condition_is_met = true;
-            for (const auto &Ra : R) {
-                bool exists = false;
-                for (const auto &ra : Ra.get_sets()) {
-                    if (ra.is_subset_eq_of(r_minus_l)) {
-                        exists = true;
-                        break;
-                    }
-                }
-                if (!exists) {
-                   condition_is_met = false;
-                   break;
-                }
+        // The obligations and the layers are only read until all threads
+        // are joined.
+        this->extend_time.resume();
+        std::atomic<size_t> next(0);
+        auto worker = [&](ExtendWorkspace &workspace)
+        {
+            for (size_t b_i = next++; b_i < batch.size(); b_i = next++)
+            {
+                results[b_i].version = L->get_version();
+                results[b_i].result = extend_explicit(Q.get(batch[b_i]).get_state(), *L, workspace);
             }
-            if (condition_is_met) {
-                r = r_minus_l;
+        };
+        std::vector<std::thread> threads;
+        int num_threads = std::min<size_t>(extend_threads, batch.size());
+        for (int t_i = 1; t_i < num_threads; t_i++)
+        {
+            threads.push_back(std::thread(worker, std::ref(workspaces[t_i])));
+        }
+        worker(workspaces[0]);
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        if (clause_database)
+        {
+            // The clauses are bumped before the layers change, even if the
+            // extension turns out stale.
+            for (auto &workspace : workspaces)
+            {
+                clause_database->bump(*L, workspace.blocking);
             }
         }
-
-        assert(r.size() > 0);
-        
-        // output condition of reason.
-        assert(r.is_subset_eq_of(s));
         this->extend_time.stop();
-        return std::pair<LiteralSet, bool>(r, false);
+
+        for (size_t b_i = 0; b_i < batch.size(); b_i++)
+        {
+            extensions[batch[b_i]] = std::move(results[b_i]);
+        }
+        this->parallel_extensions += batch.size() - 1;
     }
 
     std::shared_ptr<Layer> PDRSearch::get_layer(long unsigned int i)
@@ -194,14 +328,29 @@ namespace pdr_search
             this->seeding_time.resume();
             // no parent layer -> nullptr
             std::shared_ptr<Layer> l0 = std::shared_ptr<Layer>(new Layer(nullptr, nullptr));
-            this->heuristic->initial_heuristic_layer(0, l0);
+            if (this->heuristic)
+            {
+                this->heuristic->initial_heuristic_layer(0, l0);
+            }
             size_t seeded_layer_size = l0->size();
-            auto g = this->task_proxy.get_goals();
-            for (size_t i = 0; i < g.size(); i++)
+            if (backward)
+            {
+                // L0 only contains the initial state
+                FullState s_i = from_state(this->task_proxy.get_initial_state());
+                for (size_t var = 0; var < s_i.size(); var++)
+                {
+                    l0->add_set(LiteralSet(Literal(var, s_i[var]), SetType::CLAUSE));
+                }
+            }
+            else
             {
-                // no need to add the other literals as inverse,
-                // the goal is only a partial assignment.
-                l0->add_set(LiteralSet(Literal::from_fact(g[i]), SetType::CLAUSE));
+                auto g = this->task_proxy.get_goals();
+                for (size_t i = 0; i < g.size(); i++)
+                {
+                    // no need to add the other literals as inverse,
+                    // the goal is only a partial assignment.
+                    l0->add_set(LiteralSet(Literal::from_fact(g[i]), SetType::CLAUSE));
+                }
             }
             
             this->seeding_time.stop();     
@@ -231,10 +380,162 @@ namespace pdr_search
     void PDRSearch::initialize()
     {
         auto L0 = get_layer(0);
-        for (const auto &a: task_proxy.get_operators()) {
-           A_effect.insert(A_effect.end(), from_effect(a.get_effects()));
+        if (backward) {
+            add_backward_operators();
+        } else {
+            for (const auto &a: task_proxy.get_operators()) {
+               A_precondition.insert(A_precondition.end(), from_precondition(a.get_preconditions()));
+               A_effect.insert(A_effect.end(), from_effect(a.get_effects()));
+               A_task_operator.push_back(a.get_id());
+            }
+        }
+        A_adding.resize(FactIndex::get_num_facts());
+        A_deleting.resize(FactIndex::get_num_facts());
+        for (size_t a_i = 0; a_i < A_effect.size(); a_i++) {
+           for (const auto &l : A_effect[a_i]) {
+               if (l.is_positive()) {
+                   A_adding[l.get_fact_index()].push_back(a_i);
+               } else {
+                   A_deleting[l.get_fact_index()].push_back(a_i);
+               }
+           }
+        }
+        for (auto &workspace : workspaces)
+        {
+            workspace.operator_marks.resize(A_effect.size(), 0);
+        }
+        if (backward)
+        {
+            FullState s_i = from_state(task_proxy.get_initial_state());
+            for (size_t var = 0; var < s_i.size(); var++)
+            {
+                goal_cube.apply_cube(assignment_cube(Literal(var, s_i[var])));
+            }
+        }
+        else
+        {
+            for (const auto &g : task_proxy.get_goals())
+            {
+                goal_cube.apply_cube(assignment_cube(Literal::from_fact(g)));
+            }
+        }
+        if (backward)
+        {
+            std::vector<FactPair> goal;
+            for (const auto &g : task_proxy.get_goals())
+            {
+                goal.push_back(g.get_pair());
+            }
+            goal_states = utils::make_unique_ptr<GoalStateFinder>(
+                goal, from_state(task_proxy.get_initial_state()));
+        }
+        if (use_sat_extend)
+        {
+            sat_extender = utils::make_unique_ptr<SATExtender>(
+                A_precondition, A_effect, A_adding, A_deleting,
+                workspaces[0].reasons.get_mode() == ReasonMode::MINIMAL);
         }
+        if (reverse_search)
+        {
+            reverse_search->initialize();
+        }
+
+    }
+
+    void PDRSearch::add_backward_operators()
+    {
+        for (const auto &a : task_proxy.get_operators())
+        {
+            std::unordered_map<int, int> pre;
+            for (FactProxy f : a.get_preconditions())
+            {
+                pre[f.get_variable().get_id()] = f.get_value();
+            }
+            std::vector<FactPair> eff;
+            std::unordered_set<int> effect_vars;
+            // The predecessor can have any value of a variable that the
+            // effect sets without a precondition, a backward operator is
+            // created for each combination of their values.
+            std::vector<int> free_vars;
+            for (const auto &e : a.get_effects())
+            {
+                eff.push_back(e.get_fact().get_pair());
+                effect_vars.insert(eff.back().var);
+                if (pre.count(eff.back().var) == 0)
+                {
+                    free_vars.push_back(eff.back().var);
+                }
+            }
+
+            std::size_t num_splits = 1;
+            for (int var : free_vars)
+            {
+                num_splits *= FactIndex::get_domain_size(var);
+                if (num_splits > MAX_BACKWARD_SPLITS)
+                {
+                    std::cerr << "direction=backward does not support operator " << a.get_name()
+                              << ", it would be split into more than " << MAX_BACKWARD_SPLITS
+                              << " backward operators for the values of the variables it sets "
+                              << "without a precondition" << std::endl;
+                    utils::exit_with(utils::ExitCode::SEARCH_UNSUPPORTED);
+                }
+            }
+
+            std::vector<int> free_values(free_vars.size(), 0);
+            while (true)
+            {
+                // a applied to the predecessor gives the state, so the
+                // state has the effect and the prevail conditions of a
+                // and the predecessor its preconditions.
+                LiteralSet pre_b = LiteralSet(SetType::CUBE);
+                LiteralSet eff_b = LiteralSet(SetType::CUBE);
+                bool changes = false;
+                std::size_t free_i = 0;
+                for (const FactPair &e : eff)
+                {
+                    pre_b.add_literal(Literal(e.var, e.value));
+                    auto it = pre.find(e.var);
+                    int before = it != pre.end() ? it->second : free_values[free_i++];
+                    eff_b.apply_cube(assignment_cube(Literal(e.var, before)));
+                    changes = changes || before != e.value;
+                }
+                for (const auto &p : pre)
+                {
+                    if (effect_vars.count(p.first) == 0)
+                    {
+                        pre_b.add_literal(Literal(p.first, p.second));
+                    }
+                }
+                // operators that change nothing are not needed
+                if (changes)
+                {
+                    A_precondition.push_back(std::move(pre_b));
+                    A_effect.push_back(std::move(eff_b));
+                    A_task_operator.push_back(a.get_id());
+                }
 
+                std::size_t v_i = 0;
+                while (v_i < free_vars.size() && ++free_values[v_i] == FactIndex::get_domain_size(free_vars[v_i]))
+                {
+                    free_values[v_i] = 0;
+                    v_i++;
+                }
+                if (v_i == free_vars.size())
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    tl::optional<FullState> PDRSearch::find_source_state(const Layer &L)
+    {
+        if (backward)
+        {
+            return goal_states->find(L);
+        }
+        FullState s_i = from_state(task_proxy.get_initial_state());
+        return s_i.models(L) ? tl::optional<FullState>(s_i) : tl::nullopt;
     }
 
     void printLayers(std::vector<std::shared_ptr<Layer>> layers) {
@@ -246,8 +547,7 @@ namespace pdr_search
         std::cout << "Printing all deltas" << std::endl;
         for (size_t i = 0; i < layers.size(); ++i) {
             std::cout << "Delta " << i << ": " << std::endl;
-            auto delta = *layers[i]->get_delta();
-            for (const auto &d : delta) {
+            for (const auto &d : layers[i]->get_delta()) {
                 std::cout << d << ", ";
             }
             std::cout << std::endl;
@@ -261,10 +561,9 @@ namespace pdr_search
             std::cout << "Layer size " << i << ": " <<  this->layers[i]->size() << std::endl;
             std::cout << "Layer size (literals) " << i << ": " ;
             size_t lits = 0; 
-            auto sets = this->layers[i]->get_sets();
-            for (auto ls = sets->begin(); ls != sets->end(); ++ls)
+            for (const auto &ls : *this->layers[i])
             {
-                lits += ls->size();
+                lits += ls.size();
             }
             std::cout << lits << std::endl;
 
@@ -280,8 +579,67 @@ namespace pdr_search
         std::cout << "Total extend time: " << this->extend_time << std::endl;
         std::cout << "Total path construction phase time: " << this->path_construction_time << std::endl;
         std::cout << "Total seeding time: " << this->seeding_time <<std::endl;
+        std::cout << "Skipped propagation layers: " << this->skipped_propagation_layers << std::endl;
+        if (enable_layer_simplification)
+        {
+            std::cout << "Total layer simplification time: " << this->simplification_time << std::endl;
+            std::cout << "Simplified clauses: " << this->simplified_clauses << std::endl;
+        }
+        if (enable_inductive_generalization)
+        {
+            std::cout << "Total generalization time: " << this->generalization_time << std::endl;
+            std::cout << "Generalized literals: " << this->generalized_literals << std::endl;
+        }
         std::cout << "Total expanded obligations: " << this->obligation_expansions << std::endl;
         std::cout << "Total inserted obligations: " << this->obligation_insertions << std::endl;
+        if (enable_obligation_lifting)
+        {
+            std::cout << "Total lifting time: " << this->lifting_time << std::endl;
+            std::cout << "Obligations blocked by lifting: " << this->lifted_blocks << std::endl;
+        }
+        if (enable_obligation_keeping)
+        {
+            std::cout << "Carried over obligations: " << this->carried_obligations << std::endl;
+        }
+        if (extend_threads > 1)
+        {
+            std::cout << "Obligations extended ahead of their turn: " << this->parallel_extensions << std::endl;
+            std::cout << "Stale successors extended ahead of their turn: " << this->stale_extensions << std::endl;
+        }
+        if (clause_database)
+        {
+            clause_database->print_statistics();
+            std::cout << "Rejected fixpoints of weakened layers: " << this->rejected_fixpoints << std::endl;
+        }
+        if (exchange_clauses)
+        {
+            std::cout << "Imported shared clauses: " << this->imported_clauses << std::endl;
+            std::cout << "Rejected shared clauses: " << this->rejected_clauses << std::endl;
+        }
+        if (reverse_search)
+        {
+            std::cout << "Forward iterations: " << this->iteration << std::endl;
+            std::cout << "Backward iterations: " << reverse_search->iteration << std::endl;
+            std::cout << "Statistics of the backward search:" << std::endl;
+            reverse_search->print_statistics();
+        }
+        if (successor_evaluator)
+        {
+            successor_evaluator->print_statistics();
+        }
+        if (sat_extender)
+        {
+            sat_extender->print_statistics();
+        }
+        if (goal_states)
+        {
+            goal_states->print_statistics();
+        }
+        if (blocked_states)
+        {
+            std::cout << "Blocked states: " << this->blocked_states->size() << std::endl;
+            std::cout << "Blocked state cache hits: " << this->blocked_state_hits << std::endl;
+        }
 
         statistics.print_detailed_statistics();
         search_space.print_statistics();
@@ -289,76 +647,242 @@ namespace pdr_search
 
     SearchStatus PDRSearch::step()
     {
-        struct obligationSort
+        if (shared_clauses)
         {
-            bool operator()(const std::shared_ptr<Obligation> l, const std::shared_ptr<Obligation> r) const
+            if (shared_clauses->is_stopped())
             {
-                return l->get_priority() > r->get_priority();
+                print_progress("Stopped by the portfolio");
+                return SearchStatus::TIMEOUT;
             }
-        };
+            if (exchange_clauses)
+            {
+                import_shared_clauses();
+            }
+        }
+
+        if (reverse_search)
+        {
+            // After one iteration in each direction, the direction whose
+            // layers grew less in its last iteration is continued.
+            bool step_backward = iteration > 0 &&
+                (reverse_search->iteration == 0 ||
+                 reverse_search->iteration_clauses < this->iteration_clauses);
+            if (step_backward)
+            {
+                SearchStatus status = reverse_search->step();
+                if (status == SearchStatus::SOLVED)
+                {
+                    set_plan(reverse_search->get_plan());
+                }
+                return status;
+            }
+        }
 
-        std::cout << "Step " << iteration << " of PDR search" << std::endl;
+        std::ostringstream progress;
+        progress << "Step " << iteration << " of " << (backward ? "backward " : "") << "PDR search";
+        print_progress(progress.str());
+        this->iteration_clauses = 0;
 
         for (size_t i = 0; i < this->layers.size() - 1; ++i)
         {
             assert(this->layers[i + 1]->is_subset_eq_of(*this->layers[i]));
         }
 
-        auto X = all_variables();
-        
         size_t obligation_expansions_this_iteration = 0;
         const int k = iteration;
         iteration += 1;
 
         this->path_construction_time.resume();
-        auto s_i = from_state(this->task_proxy.get_initial_state());
-        if (s_i.models(*get_layer(k)))
+        tl::optional<FullState> source = find_source_state(*get_layer(k));
+        if (source)
         {
-            auto o = std::shared_ptr<Obligation>(new Obligation(s_i, k, nullptr));
-            std::priority_queue<std::shared_ptr<Obligation>, std::vector<std::shared_ptr<Obligation>>, obligationSort> Q;
-            Q.push(o);
+            if (goal_states)
+            {
+                // the root is blocked in Lk before the next query
+                goal_states->exclude(*source, *get_layer(k));
+            }
+            ObligationManager &Q = this->obligations;
+            int root = Obligation::NO_PARENT;
+            if (enable_obligation_keeping)
+            {
+                // The blocked obligations of the previous iterations are
+                // pushed again, together with the paths that lead to them.
+                for (int ob : Q.keep(this->blocked_obligations))
+                {
+                    if (Q.get(ob).get_parent() == Obligation::NO_PARENT)
+                    {
+                        root = ob;
+                        continue;
+                    }
+                    Q.set_priority(ob, std::min(Q.get(ob).get_priority(), k));
+                    Q.push(ob);
+                    this->obligation_insertions += 1;
+                    this->carried_obligations += 1;
+                }
+                this->blocked_obligations.clear();
+            }
+            else
+            {
+                // obligations of the previous iteration are released here
+                Q.clear();
+            }
+            if (root == Obligation::NO_PARENT)
+            {
+                root = Q.create(std::move(*source), k, Obligation::NO_PARENT);
+            }
+            else
+            {
+                Q.set_priority(root, k);
+            }
+            Q.push(root);
             this->obligation_insertions += 1;
 
-            while (!Q.empty())
+            // Extensions of queued obligations that were computed together
+            // with an earlier one, see extend_batch.
+            std::unordered_map<int, Extension> extensions;
+            // Backward, Lk can contain several goal states. Once all
+            // obligations are blocked, the next one becomes the root.
+            auto push_next_root = [&]()
             {
-                auto si = Q.top();
-                Q.pop();
+                if (!backward)
+                {
+                    return false;
+                }
+                source = find_source_state(*get_layer(k));
+                if (!source)
+                {
+                    return false;
+                }
+                goal_states->exclude(*source, *get_layer(k));
+                Q.push(Q.create(std::move(*source), k, Obligation::NO_PARENT));
+                this->obligation_insertions += 1;
+                return true;
+            };
+            while (!Q.empty() || push_next_root())
+            {
+                if (shared_clauses && shared_clauses->is_stopped())
+                {
+                    print_progress("Stopped by the portfolio");
+                    this->path_construction_time.stop();
+                    return SearchStatus::TIMEOUT;
+                }
+                int si = Q.pop();
+                tl::optional<Extension> extension;
+                auto it = extensions.find(si);
+                if (it != extensions.end())
+                {
+                    extension = std::move(it->second);
+                    extensions.erase(it);
+                }
                 this->obligation_expansions += 1;
                 obligation_expansions_this_iteration += 1;
-                int i = si->get_priority();
-                auto s = si->get_state();
+                int i = Q.get(si).get_priority();
+                // s is invalidated when new obligations are created
+                const FullState &s = Q.get(si).get_state();
+                if (i > 0 && clause_database && clause_database->is_weakened(i - 1) && s.models(*get_layer(i - 1)))
+                {
+                    // s is outside of Li-1 as long as the layers are
+                    // relatively inductive. Evicted clauses can let it
+                    // into Li-1 again, then it is continued there.
+                    Q.set_priority(si, i - 1);
+                    Q.push(si);
+                    this->obligation_insertions += 1;
+                    continue;
+                }
                 if (i == 0)
                 {
-                    extract_path(si, s_i);
+                    extract_path(si);
                     this->path_construction_time.stop();
                     this->obligation_expansions_per_layer.insert(this->obligation_expansions_per_layer.end(), 
                             obligation_expansions_this_iteration);
                     return SearchStatus::SOLVED;
                 }
 
-                auto extended = extend(s, *get_layer(i - 1));
-                if (extended.second)
+                if (blocked_states)
                 {
-                    // extend returns a successor state t
-                    LiteralSet &t = extended.first;
-                    Q.push(si);
-                    auto newObligation = std::shared_ptr<Obligation>(new Obligation(t, si->get_priority() - 1, si));
-                    Q.push(newObligation);
-                    this->obligation_insertions += 2;
+                    // s is already known to be excluded from L_i,
+                    // extend would only find the same reason again.
+                    int blocked = blocked_states->get_blocked_layer(s);
+                    if (blocked >= i)
+                    {
+                        this->blocked_state_hits += 1;
+                        if (enable_obligation_rescheduling && blocked < k)
+                        {
+                            Q.set_priority(si, blocked + 1);
+                            Q.push(si);
+                            this->obligation_insertions += 1;
+                        }
+                        else if (enable_obligation_keeping)
+                        {
+                            Q.set_priority(si, blocked + 1);
+                            this->blocked_obligations.push_back(si);
+                        }
+                        continue;
+                    }
                 }
-                else
-                {
-                    LiteralSet &r = extended.first;
-                    // Only add to set L_i, because of layer delta encoding
-                    auto L_i = get_layer(i);
-                    L_i->add_set(r.invert());
 
-                    if (enable_obligation_rescheduling && i < k)
+                tl::optional<LiteralSet> reason;
+                if (enable_obligation_lifting)
+                {
+                    reason = block_lifted(s, i);
+                }
+                if (!reason)
+                {
+                    auto L = get_layer(i - 1);
+                    if (!extension && extend_threads > 1)
+                    {
+                        extend_batch(si, i, extensions);
+                        extension = std::move(extensions[si]);
+                        extensions.erase(si);
+                    }
+                    // A reason stays valid when clauses are added to L, a
+                    // successor has to be checked against the new clauses.
+                    if (extension && extension->result.first && extension->version != L->get_version() &&
+                        !extension->result.first->models(*L))
                     {
-                        auto newObligation = std::shared_ptr<Obligation>(new Obligation(s, i + 1, si->get_parent()));
-                        Q.push(newObligation);
-                        this->obligation_insertions += 1;
+                        this->stale_extensions += 1;
+                        extension = tl::nullopt;
                     }
+                    auto extended = extension ? std::move(extension->result) : extend(s, *L);
+                    if (extended.first)
+                    {
+                        // extend returns a successor state t
+                        Q.push(si);
+                        Q.push(Q.create(std::move(*extended.first), i - 1, si));
+                        this->obligation_insertions += 2;
+                        continue;
+                    }
+                    reason = std::move(extended.second);
+                }
+                LiteralSet &r = *reason;
+                // Only add to set L_i, because of layer delta encoding
+                auto L_i = get_layer(i);
+                if (enable_inductive_generalization)
+                {
+                    r = generalize(r, *get_layer(i - 1), *L_i);
+                }
+                L_i->add_set(r.invert());
+                this->iteration_clauses += 1;
+                if (exchange_clauses)
+                {
+                    shared_clauses->publish(portfolio_index, {std::make_pair(i, r.invert())});
+                }
+                if (blocked_states)
+                {
+                    blocked_states->set_blocked(s, i);
+                }
+
+                if (enable_obligation_rescheduling && i < k)
+                {
+                    // reuse the blocked obligation, it is not queued anymore
+                    Q.set_priority(si, i + 1);
+                    Q.push(si);
+                    this->obligation_insertions += 1;
+                }
+                else if (enable_obligation_keeping)
+                {
+                    Q.set_priority(si, i + 1);
+                    this->blocked_obligations.push_back(si);
                 }
                 for (size_t i = 0; i < this->layers.size() - 1; ++i)
                 {
@@ -370,8 +894,6 @@ namespace pdr_search
 
         // Clause propagation
         this->clause_propagation_time.resume();
-        auto A = this->task_proxy.get_operators();
-
         for (size_t j = 0; j < this->layers.size() - 1; ++j)
         {
             assert(this->layers[j + 1]->is_subset_eq_of(*(this->layers[j])));
@@ -379,41 +901,91 @@ namespace pdr_search
         for (int i = 1; i <= k + 1; i++)
         {
             std::shared_ptr<Layer> Li1 = get_layer(i - 1);
-            // NOTE: this copy can not be prevented by dereferencing the 
-            // pointer in the for loop. The layer Li-1 gets modified inside of the 
-            // loop. Without copying the iterator gets invalidated and crashes on linux.
-            auto delta = *Li1->get_delta();
-            for (const auto c : delta)
+            // Create (and seed) Li before iterating, seeding can move
+            // clauses out of the delta of Li-1.
+            std::shared_ptr<Layer> Li = get_layer(i);
+            if (propagated_versions.size() <= static_cast<size_t>(i))
+            {
+                propagated_versions.resize(i + 1, std::numeric_limits<std::size_t>::max());
+            }
+            if (propagated_versions[i] == Li1->get_version())
             {
-                LiteralSet s_c = LiteralSet(X.get_literals(), SetType::CUBE);
-                for (const auto &p : c.get_literals())
+                // No clause of the delta of Li-1 can be pushed, but extend
+                // may have moved clauses out of it.
+                this->skipped_propagation_layers += 1;
+                if (Li1->get_delta().empty() && is_fixpoint(i - 1))
                 {
-                    s_c.apply_literal(p.neg());
+                    this->clause_propagation_time.stop();
+                    this->obligation_expansions_per_layer.insert(this->obligation_expansions_per_layer.end(), 
+                            obligation_expansions_this_iteration);
+                    return SearchStatus::FAILED;
                 }
+                continue;
+            }
+            // The layer Li-1 gets modified when the pushed clauses are
+            // committed, they are moved out of its delta. The snapshot
+            // keeps the delta from being compacted meanwhile.
+            DeltaSnapshot delta(Li1->get_delta());
+            std::vector<const LiteralSet *> candidates;
+            for (const auto &c : delta)
+            {
+                candidates.push_back(&c);
+            }
 
-                bool for_all_not_models = true;
-                for (size_t a_i = 0; a_i < A.size(); a_i++)
+            // Pushing a clause to Li does not change Li-1 (Li ⊆ Li-1),
+            // so all candidates can be checked independently.
+            std::vector<char> push(candidates.size(), false);
+            if (propagation_threads > 1 && candidates.size() > 1)
+            {
+                std::atomic<size_t> next(0);
+                auto worker = [&]()
                 {
-                    LiteralSet pre_a = from_precondition(A[a_i].get_preconditions());
-                    LiteralSet applied = LiteralSet(s_c);
-                    LiteralSet effect_a = A_effect[a_i];
-                    for (const auto &l : effect_a.get_literals())
+                    for (size_t c_i = next++; c_i < candidates.size(); c_i = next++)
                     {
-                        applied.apply_literal(l);
-                    }
-                    if (!(!s_c.models(pre_a) || !applied.models(*get_layer(i - 1))))
-                    {
-                        for_all_not_models = false;
-                        break;
+                        push[c_i] = can_push(*candidates[c_i], *Li1);
                     }
+                };
+                std::vector<std::thread> threads;
+                int num_threads = std::min<size_t>(propagation_threads, candidates.size());
+                for (int t_i = 1; t_i < num_threads; t_i++)
+                {
+                    threads.push_back(std::thread(worker));
+                }
+                worker();
+                for (auto &thread : threads)
+                {
+                    thread.join();
                 }
-                if (for_all_not_models)
+            }
+            else
+            {
+                for (size_t c_i = 0; c_i < candidates.size(); c_i++)
+                {
+                    push[c_i] = can_push(*candidates[c_i], *Li1);
+                }
+            }
+
+            std::vector<std::pair<int, LiteralSet>> pushed;
+            for (size_t c_i = 0; c_i < candidates.size(); c_i++)
+            {
+                if (push[c_i])
                 {
-                    get_layer(i)->add_set(c);
+                    if (exchange_clauses)
+                    {
+                        pushed.emplace_back(i, *candidates[c_i]);
+                    }
+                    // moves the clause out of the delta of Li-1
+                    Li->add_set(*candidates[c_i]);
                 }
             }
+            if (exchange_clauses)
+            {
+                shared_clauses->publish(portfolio_index, pushed);
+            }
+            // pushing clauses to Li does not change Li-1
+            propagated_versions[i] = Li1->get_version();
             // Li-1 == Li
-            if (get_layer(i-1)->get_delta()->empty())
+            if (get_layer(i-1)->get_delta().empty() && is_fixpoint(i - 1))
             {
                 this->clause_propagation_time.stop();
                 this->obligation_expansions_per_layer.insert(this->obligation_expansions_per_layer.end(), 
@@ -426,98 +998,372 @@ namespace pdr_search
             }
         }
         this->clause_propagation_time.stop();
+
+        if (enable_layer_simplification)
+        {
+            this->simplification_time.resume();
+            // Simplify the children first, their clauses subsume the
+            // clauses of the parents.
+            for (size_t i = this->layers.size(); i-- > 0;)
+            {
+                this->simplified_clauses += this->layers[i]->simplify();
+            }
+            for (size_t j = 0; j < this->layers.size() - 1; ++j)
+            {
+                assert(this->layers[j + 1]->is_subset_eq_of(*(this->layers[j])));
+            }
+            this->simplification_time.stop();
+        }
+        if (clause_database && clause_database->reduce(this->layers) > 0)
+        {
+            // The evicted clauses may have excluded the blocked states
+            // and are still encoded in the solver.
+            if (blocked_states)
+            {
+                blocked_states->clear();
+            }
+            if (sat_extender)
+            {
+                sat_extender->forget_layer_clauses();
+            }
+            if (goal_states)
+            {
+                goal_states->forget_layer_clauses();
+            }
+        }
         this->obligation_expansions_per_layer.insert(this->obligation_expansions_per_layer.end(), 
                 obligation_expansions_this_iteration);
         return SearchStatus::IN_PROGRESS;
     }
 
-    void PDRSearch::extract_path(const std::shared_ptr<Obligation> goal_obligation, const LiteralSet initialState)
+    void PDRSearch::join_portfolio(const std::shared_ptr<SharedClauses> &clauses, int index, bool exchange)
     {
-        std::shared_ptr<Obligation> ob = goal_obligation;
-        std::vector<LiteralSet> state_list = std::vector<LiteralSet>();
-        do
+        shared_clauses = clauses;
+        portfolio_index = index;
+        exchange_clauses = exchange;
+        shared_position = 0;
+        if (reverse_search)
         {
-            state_list.insert(state_list.begin(), ob->get_state());
-            ob = ob->get_parent();
-        } while (ob->get_parent() != nullptr);
-        state_list.insert(state_list.begin(), initialState);
+            // only to stop with this search, this one exchanges the clauses
+            reverse_search->join_portfolio(clauses, index, false);
+        }
+    }
 
-        std::vector<OperatorID> plan;
-        auto operators = task_proxy.get_operators();
-        for (size_t i = 1; i < state_list.size(); i++)
+    SearchStatus PDRSearch::search_in_portfolio()
+    {
+        utils::CountdownTimer timer(max_time);
+        SearchStatus status = IN_PROGRESS;
+        while (status == IN_PROGRESS)
         {
-            OperatorID matched_op = OperatorID::no_operator;
-            for (size_t a_i = 0; a_i < operators.size(); a_i++)
+            status = step();
+            if (status == IN_PROGRESS && timer.is_expired())
+            {
+                print_progress("Time limit reached");
+                status = TIMEOUT;
+            }
+        }
+        return status;
+    }
+
+    void PDRSearch::print_progress(const std::string &message) const
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        if (shared_clauses)
+        {
+            std::cout << "[search " << portfolio_index << "] ";
+        }
+        std::cout << message << std::endl;
+    }
+
+    void PDRSearch::import_shared_clauses()
+    {
+        for (const auto &shared : shared_clauses->collect(portfolio_index, shared_position))
+        {
+            const LiteralSet &c = shared.second;
+            // c holds in the goal states, as a clause of the other search.
+            // Added to Lj it is in all layers below as well, so it keeps
+            // them relatively inductive if no operator leads from a state
+            // violating c to Lj-1. Lj-1 grows with j, which only makes
+            // this harder, so going down from the top, the first layer
+            // where it holds is the highest one that c can be added to.
+            int top = std::min<int>(shared.first, this->layers.size() - 1);
+            bool imported = false;
+            for (int j = top; j >= 1; j--)
             {
-                auto pre = from_precondition(operators[a_i].get_preconditions());
-                auto state = state_list[i - 1];
-                if (!state.models(pre))
+                std::shared_ptr<Layer> Lj = get_layer(j);
+                if (Lj->contains_set(c))
                 {
-                    continue;
+                    break;
                 }
-                auto eff = A_effect[a_i];
-                state.apply_cube(eff);
-                if (state != state_list[i])
+                if (can_push(c, *get_layer(j - 1)))
                 {
-                    continue;
+                    Lj->add_set(c);
+                    imported = true;
+                    break;
                 }
-                matched_op = OperatorID(operators[a_i].get_id());
             }
-            assert(matched_op != OperatorID::no_operator);
-            plan.insert(plan.end(), matched_op);
+            if (imported)
+            {
+                this->imported_clauses += 1;
+            }
+            else
+            {
+                this->rejected_clauses += 1;
+            }
         }
-        assert(plan.size() == state_list.size() - 1);
-        set_plan(plan);
     }
 
-    LiteralSet PDRSearch::from_state(const State &s) const
+    bool PDRSearch::is_fixpoint(int i)
     {
-        s.unpack();
+        if (!clause_database || !clause_database->is_weakened(i))
+        {
+            return true;
+        }
+        const Layer &L = *this->layers[i];
+        bool fixpoint = !find_source_state(L);
+        for (auto it = L.begin(); fixpoint && it != L.end(); ++it)
+        {
+            fixpoint = can_push(*it, L);
+        }
+        if (!fixpoint)
+        {
+            this->rejected_fixpoints += 1;
+        }
+        return fixpoint;
+    }
 
-        int i = 0;
-        std::unordered_set<Literal, LiteralHash> result;
-        for (const auto &value : s.get_unpacked_values())
+    std::vector<int> PDRSearch::adding_operators(const LiteralSet &c) const
+    {
+        std::vector<int> ops;
+        for (const auto &l : c)
         {
-            Literal v = Literal::from_fact(FactProxy(*task, i, value));
-            result.insert(result.begin(), v);
-            i += 1;
+            const auto &candidates = l.is_positive() ? A_adding[l.get_fact_index()] : A_deleting[l.get_fact_index()];
+            ops.insert(ops.end(), candidates.begin(), candidates.end());
         }
-        LiteralSet c = LiteralSet(result, SetType::CUBE);
+        std::sort(ops.begin(), ops.end());
+        ops.erase(std::unique(ops.begin(), ops.end()), ops.end());
+        return ops;
+    }
 
-        auto vars = this->task_proxy.get_variables();
-        int variable_index = 0;
-        for (const auto &var : vars)
+    bool PDRSearch::can_push(const LiteralSet &c, const Layer &Li1) const
+    {
+        // The states violating c as a partial assignment: the facts of the
+        // positive literals of c are false, the facts of the negative
+        // literals are true and thus the other values of their variables false.
+        LiteralSet s_c = LiteralSet(SetType::CUBE);
+        for (const auto &l : c)
         {
-            int dom_size = var.get_domain_size();
-            for (int i = 0; i < dom_size; i++)
+            if (s_c.contains_literal(l))
+            {
+                // no state violates c
+                return true;
+            }
+            if (l.is_positive())
             {
-                Literal l = Literal::from_fact(FactProxy(*task, variable_index, i));
-                if (!c.contains_literal(l))
+                s_c.add_literal(l.invert());
+                continue;
+            }
+            s_c.apply_cube(assignment_cube(l.invert()));
+        }
+
+        // Every literal of c is false in s_c, so applied can only model
+        // c ∈ Li-1 if a makes one of its literals true.
+        for (int a_i : adding_operators(c))
+        {
+            if (!s_c.is_consistent_with(A_precondition[a_i]))
+            {
+                continue;
+            }
+            LiteralSet applied = LiteralSet(s_c);
+            applied.apply_cube(A_effect[a_i]);
+            if (applied.may_model(Li1))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    tl::optional<LiteralSet> PDRSearch::block_lifted(const FullState &s, int i)
+    {
+        this->lifting_time.resume();
+        const Layer &Li1 = *get_layer(i - 1);
+        // Like ternary simulation: the other variables of s can take any
+        // value and all states of g still violate Li-1.
+        const LiteralSet *smallest = nullptr;
+        for (const auto &c : Li1)
+        {
+            if (!s.models(c) && (!smallest || c.size() < smallest->size()))
+            {
+                smallest = &c;
+            }
+        }
+        assert(smallest);
+        LiteralSet g = LiteralSet(SetType::CUBE);
+        for (const auto &l : *smallest)
+        {
+            Literal fact = Literal(l.get_variable(), s[l.get_variable()]);
+            if (!g.contains_literal(fact))
+            {
+                g.add_literal(fact);
+            }
+        }
+        // For a complete state extend finds a better reason.
+        bool blocked = g.size() < s.size() && is_relatively_inductive(g, Li1, *get_layer(i));
+        this->lifting_time.stop();
+        if (!blocked)
+        {
+            return tl::nullopt;
+        }
+        this->lifted_blocks += 1;
+        return g;
+    }
+
+    bool PDRSearch::propagate(LiteralSet &p, const Layer &L) const
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (const auto &c : L)
+            {
+                Literal unit = Literal(0, 0);
+                switch (p.get_clause_status(c, unit))
                 {
-                    c.add_literal(l.invert());
+                case ClauseStatus::CONFLICT:
+                    return false;
+                case ClauseStatus::UNIT:
+                    if (unit.is_positive())
+                    {
+                        p.apply_cube(assignment_cube(unit));
+                    }
+                    else
+                    {
+                        p.add_literal(unit);
+                    }
+                    changed = true;
+                    break;
+                default:
+                    break;
                 }
             }
-            variable_index += 1;
         }
-        return c;
+        return true;
     }
 
-    LiteralSet PDRSearch::all_variables() const
+    bool PDRSearch::is_relatively_inductive(const LiteralSet &r, const Layer &Li1, const Layer &Li) const
     {
-        LiteralSet c = LiteralSet(SetType::CUBE);
-        auto vars = this->task_proxy.get_variables();
-        int variable_index = 0;
-        for (const auto &var : vars)
+        // r as partial assignment, a true fact makes the other values of
+        // its variable false
+        LiteralSet s_r = LiteralSet(SetType::CUBE);
+        for (const auto &l : r)
         {
-            int dom_size = var.get_domain_size();
-            for (int i = 0; i < dom_size; i++)
+            if (l.is_positive())
+            {
+                s_r.apply_cube(assignment_cube(l));
+            }
+            else if (!s_r.contains_literal(l))
+            {
+                s_r.add_literal(l);
+            }
+        }
+
+        if (!propagate(s_r, Li))
+        {
+            return true;
+        }
+        // goal states are in Li as well
+        if (s_r.is_consistent_with(goal_cube))
+        {
+            return false;
+        }
+
+        // Operators that leave all literals of r untouched lead to r again.
+        for (int a_i : adding_operators(r.invert()))
+        {
+            if (!s_r.is_consistent_with(A_precondition[a_i]))
             {
-                Literal l = Literal::from_fact(FactProxy(*task, variable_index, i));
-                c.add_literal(l);
+                continue;
+            }
+            LiteralSet applied = LiteralSet(s_r);
+            applied.apply_cube(A_effect[a_i]);
+            if (propagate(applied, Li1))
+            {
+                return false;
             }
-            variable_index += 1;
         }
-        return c;
+        return true;
+    }
+
+    LiteralSet PDRSearch::generalize(const LiteralSet &r, const Layer &Li1, const Layer &Li)
+    {
+        this->generalization_time.resume();
+        LiteralSet g = r;
+        for (const auto &l : r)
+        {
+            if (g.size() == 1)
+            {
+                break;
+            }
+            g.remove_literal(l);
+            if (is_relatively_inductive(g, Li1, Li))
+            {
+                this->generalized_literals += 1;
+            }
+            else
+            {
+                g.add_literal(l);
+            }
+        }
+        this->generalization_time.stop();
+        return g;
+    }
+
+    void PDRSearch::extract_path(int goal_obligation)
+    {
+        // The states from the obligation in layer 0 to the root, each one
+        // is a successor of the next one in the direction of the search.
+        std::vector<FullState> state_list;
+        for (int ob = goal_obligation; ob != Obligation::NO_PARENT; ob = obligations.get(ob).get_parent())
+        {
+            state_list.push_back(obligations.get(ob).get_state());
+        }
+
+        std::vector<OperatorID> plan;
+        for (size_t i = 1; i < state_list.size(); i++)
+        {
+            OperatorID matched_op = OperatorID::no_operator;
+            for (size_t a_i = 0; a_i < A_effect.size(); a_i++)
+            {
+                auto state = state_list[i];
+                if (!state.models(A_precondition[a_i]))
+                {
+                    continue;
+                }
+                state.apply_cube(A_effect[a_i]);
+                if (state == state_list[i - 1])
+                {
+                    matched_op = OperatorID(A_task_operator[a_i]);
+                    break;
+                }
+            }
+            assert(matched_op != OperatorID::no_operator);
+            plan.insert(plan.end(), matched_op);
+        }
+        assert(plan.size() == state_list.size() - 1);
+        // Forward, the list ends with the initial state. Backward, it
+        // starts with it and the operators are applied in reverse.
+        if (!backward)
+        {
+            std::reverse(plan.begin(), plan.end());
+        }
+        set_plan(plan);
+    }
+
+    FullState PDRSearch::from_state(const State &s) const
+    {
+        s.unpack();
+        return FullState(s.get_unpacked_values());
     }
 
     LiteralSet PDRSearch::from_precondition(const PreconditionsProxy &pc) const
@@ -543,7 +1389,7 @@ namespace pdr_search
             int dom_size = fact.get_variable().get_domain_size();
             for (int i = 0; i < dom_size; i++)
             {
-                Literal l = Literal::from_fact(FactProxy(*task, variable, i));
+                Literal l = Literal(variable, i);
                 if (!ls.contains_literal(l))
                 {
                     ls.add_literal(l.invert());
@@ -553,15 +1399,95 @@ namespace pdr_search
         return ls;
     }
 
-    PDRSearch::PDRSearch(const Options &opts) : SearchEngine(opts)
+    PDRSearch::PDRSearch(const Options &opts) : SearchEngine(opts),
+        obligations(opts.get<ObligationTieBreaking>("ob-tie-breaking"))
     {
+        FactIndex::initialize(*task);
         enable_obligation_rescheduling = opts.get<bool>("ob-resched");
         enable_layer_simplification = opts.get<bool>("s-layers");
+        enable_inductive_generalization = opts.get<bool>("ind-gen");
+        enable_obligation_keeping = opts.get<bool>("keep-obligations");
+        enable_obligation_lifting = opts.get<bool>("lift-obligations");
+        SearchDirection direction = opts.get<SearchDirection>("direction");
+        backward = direction == SearchDirection::BACKWARD;
+        if (direction != SearchDirection::FORWARD && enable_obligation_keeping)
+        {
+            std::cerr << "keep-obligations is only supported forward, "
+                      << "backward there can be several root obligations" << std::endl;
+            utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+        }
+        propagation_threads = opts.get<int>("propagation-threads");
+        use_sat_extend = opts.get<bool>("sat-extend");
+        extend_threads = opts.get<int>("extend-threads");
+        workspaces.resize(extend_threads, ExtendWorkspace(opts.get<ReasonMode>("reason-mode")));
+        if (extend_threads > 1 && use_sat_extend)
+        {
+            std::cerr << "extend-threads can not be combined with sat-extend, "
+                      << "the solver can only answer one query at a time" << std::endl;
+            utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+        }
+        std::shared_ptr<Evaluator> evaluator = opts.get<std::shared_ptr<Evaluator>>("successor-eval", nullptr);
+        if (evaluator)
+        {
+            if (direction != SearchDirection::FORWARD)
+            {
+                std::cerr << "successor-eval is only supported forward, "
+                          << "it estimates the distance to the goal" << std::endl;
+                utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+            }
+            if (extend_threads > 1)
+            {
+                std::cerr << "successor-eval can not be combined with extend-threads, "
+                          << "the evaluator is not thread-safe" << std::endl;
+                utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+            }
+            if (use_sat_extend)
+            {
+                std::cerr << "successor-eval can not be combined with sat-extend, "
+                          << "the solver only finds one successor" << std::endl;
+                utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+            }
+            if (evaluator->does_cache_estimates())
+            {
+                std::cerr << "successor-eval must not cache its estimates, "
+                          << "use successor-cache instead" << std::endl;
+                utils::exit_with(utils::ExitCode::SEARCH_INPUT_ERROR);
+            }
+            successor_evaluator = utils::make_unique_ptr<SuccessorEvaluator>(
+                evaluator, task_proxy, task_properties::g_state_packers[task_proxy], opts.get<bool>("successor-cache"));
+        }
+        int clause_memory = opts.get<int>("clause-memory");
+        if (clause_memory != std::numeric_limits<int>::max())
+        {
+            clause_database = utils::make_unique_ptr<ClauseDatabase>(static_cast<std::size_t>(clause_memory) * 1024 * 1024);
+        }
+        if (opts.get<bool>("blocked-cache"))
+        {
+            blocked_states = utils::make_unique_ptr<BlockedStateCache>(task_properties::g_state_packers[task_proxy]);
+        }
 
         std::shared_ptr<PDRHeuristic> pdr_heuristic =
             opts.get<std::shared_ptr<PDRHeuristic>>("heuristic");
 
         heuristic = pdr_heuristic;
+        if (backward && !heuristic->holds_in_reachable_states())
+        {
+            std::cout << "The pdr heuristic is not used backward, "
+                      << "its clauses do not hold in all reachable states" << std::endl;
+            heuristic = nullptr;
+        }
+
+        if (direction == SearchDirection::ALTERNATING)
+        {
+            Options backward_opts(opts);
+            backward_opts.set<SearchDirection>("direction", SearchDirection::BACKWARD);
+            reverse_search = utils::make_unique_ptr<PDRSearch>(backward_opts);
+        }
+    }
+
+    bool PDRSearch::is_backward() const
+    {
+        return backward;
     }
 
     PDRSearch::~PDRSearch()
@@ -576,7 +1502,46 @@ namespace pdr_search
             "pdr heuristic",
             "pdr-noop()");
         parser.add_option<bool>("ob-resched", "enable obligation scheduling", "true");
-        parser.add_option<bool>("s-layers", "enable layer simplification", "false");
+        parser.add_enum_option<SearchDirection>(
+            "direction",
+            {"forward", "backward", "alternating"},
+            "forward: layers over-approximate the states that reach the goal, obligations start at the initial state; "
+            "backward: layers over-approximate the states reachable from the initial state, obligations start at goal states; "
+            "alternating: runs both and continues the direction whose layers grew less in its last iteration. "
+            "Backward, an operator is split for every combination of values of the variables it sets without a precondition; "
+            "tasks with an operator that needs more than 64 splits are not supported",
+            "forward");
+        parser.add_enum_option<ObligationTieBreaking>(
+            "ob-tie-breaking",
+            {"lifo", "fifo"},
+            "order of obligations with the same priority",
+            "lifo");
+        parser.add_enum_option<ReasonMode>(
+            "reason-mode",
+            {"greedy", "minimal"},
+            "greedy: cover every candidate family once; minimal: also drop the literals that are not needed",
+            "minimal");
+        parser.add_option<bool>("s-layers", "remove subsumed clauses from the layers and strengthen clauses by resolution after clause propagation", "false");
+        parser.add_option<bool>("ind-gen", "drop literals of blocking clauses while they stay relatively inductive", "false");
+        parser.add_option<bool>("keep-obligations", "carry the obligations blocked at the last layer and their paths over to the next iteration", "false");
+        parser.add_option<bool>("lift-obligations", "before extending an obligation, try to block the partial state of the variables of the smallest clause of the layer below that it violates", "false");
+        parser.add_option<std::shared_ptr<Evaluator>>(
+            "successor-eval",
+            "evaluator that picks the successor with the smallest value among all successors "
+            "that extend finds in the layer below. It must not cache its estimates "
+            "(cache_estimates=false). Without it the successor of the operator "
+            "with the smallest id is taken",
+            OptionParser::NONE);
+        parser.add_option<bool>("successor-cache", "cache the values of successor-eval per state", "true");
+        parser.add_option<bool>("blocked-cache", "remember blocked states across iterations and skip their obligations", "false");
+        parser.add_option<bool>("sat-extend", "answer extend with an incremental SAT solver that encodes the transition relation and the layers once; "
+                                "the reason is the part of the state in the final conflict, minimized if reason-mode=minimal", "false");
+        parser.add_option<int>("clause-memory", "memory limit of the layer clauses in MB. Above it, subsumed clauses are removed "
+                               "and the clauses that blocked the fewest successors in extend recently are evicted, long ones first; "
+                               "with sat-extend no activity is tracked", "infinity", Bounds("1", "infinity"));
+        parser.add_option<int>("propagation-threads", "number of threads used for clause propagation", "1", Bounds("1", "infinity"));
+        parser.add_option<int>("extend-threads", "number of threads that extend the queued obligations of the same layer concurrently; "
+                               "their successors and reasons are committed one after another in the order of the queue", "1", Bounds("1", "infinity"));
     }
 
     // helper method to print sets of SetOfliteralSets
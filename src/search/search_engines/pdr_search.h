@@ -4,15 +4,25 @@
 #include "../search_engine.h"
 #include "search_common.h"
 
+#include "../pdr/clause-database.h"
 #include "../pdr/data-structures.h"
+#include "../pdr/goal-states.h"
 #include "../pdr/heuristic.h"
+#include "../pdr/reasons.h"
+#include "../pdr/sat-extend.h"
+#include "../pdr/shared-clauses.h"
+#include "../pdr/successors.h"
+
+#include <optional.hh>
 
 #include <cstddef>
 #include <vector>
 #include <set>
+#include <unordered_map>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <string>
 
 namespace options
 {
@@ -24,11 +34,61 @@ namespace pdr_search
 {
 
     void printLayers(std::vector<std::shared_ptr<Layer>> layers);
+
+    enum class SearchDirection
+    {
+        // layers of states that can reach the goal, obligations from the
+        // initial state
+        FORWARD,
+        // layers of states reachable from the initial state, obligations
+        // from the goal states
+        BACKWARD,
+        // both, one iteration at a time
+        ALTERNATING,
+    };
     
+    class PDRPortfolio;
+
     class PDRSearch : public SearchEngine
     {
+        // initializes its searches and runs them in parallel
+        friend class PDRPortfolio;
+
+        // Scratch space of the explicit extend, every thread that extends
+        // obligations has its own.
+        struct ExtendWorkspace
+        {
+            ReasonGeneralizer reasons;
+            std::vector<std::size_t> operator_marks;
+            std::size_t operator_mark = 0;
+            // The clauses that blocked a successor, collected for the
+            // clause database until they are bumped.
+            std::vector<const LiteralSet *> blocking;
+
+            ExtendWorkspace(ReasonMode mode) : reasons(mode) {}
+        };
+
+        // The result of extending a queued obligation ahead of its turn
+        // and the version of the layer it was extended into.
+        struct Extension
+        {
+            std::size_t version;
+            std::pair<tl::optional<FullState>, LiteralSet> result =
+                std::make_pair(tl::optional<FullState>(), LiteralSet(SetType::CUBE));
+        };
+
         bool enable_obligation_rescheduling = true;
         bool enable_layer_simplification = false;
+        bool enable_inductive_generalization = false;
+        bool enable_obligation_keeping = false;
+        bool enable_obligation_lifting = false;
+        int propagation_threads = 1;
+        int extend_threads = 1;
+        // Backward, the operators are reversed and the roles of the initial
+        // state and the goal are swapped (see add_backward_operators).
+        bool backward = false;
+        // The backward search that alternates with this one.
+        std::unique_ptr<PDRSearch> reverse_search;
 
         std::shared_ptr<PDRHeuristic> heuristic;
         std::vector<std::shared_ptr<Layer>> layers;
@@ -37,25 +97,149 @@ namespace pdr_search
         utils::Timer extend_time = utils::Timer(false);
         utils::Timer path_construction_time = utils::Timer(false);
         utils::Timer clause_propagation_time = utils::Timer(false);
+        utils::Timer generalization_time = utils::Timer(false);
+        utils::Timer simplification_time = utils::Timer(false);
+        utils::Timer lifting_time = utils::Timer(false);
         std::size_t obligation_expansions = 0;
         std::size_t obligation_insertions = 0;
+        std::size_t blocked_state_hits = 0;
+        std::size_t generalized_literals = 0;
+        std::size_t skipped_propagation_layers = 0;
+        std::size_t simplified_clauses = 0;
+        std::size_t carried_obligations = 0;
+        std::size_t lifted_blocks = 0;
+        std::size_t parallel_extensions = 0;
+        std::size_t stale_extensions = 0;
+        std::size_t imported_clauses = 0;
+        std::size_t rejected_clauses = 0;
+        std::size_t rejected_fixpoints = 0;
+        // blocking clauses added in the last iteration
+        std::size_t iteration_clauses = 0;
         std::vector<size_t> obligation_expansions_per_layer;
+        ObligationManager obligations;
+        // The obligations that were blocked and not rescheduled in the
+        // previous iteration, they are carried over to the next one with
+        // the layer above the blocking layer as priority.
+        std::vector<int> blocked_obligations;
+        std::unique_ptr<BlockedStateCache> blocked_states;
+        std::unique_ptr<SuccessorEvaluator> successor_evaluator;
+        // Answers extend instead of the explicit enumeration of the
+        // operators if sat-extend is set. Created in initialize.
+        std::unique_ptr<SATExtender> sat_extender;
+        bool use_sat_extend = false;
+        // Finds the root obligations backward. Created in initialize.
+        std::unique_ptr<GoalStateFinder> goal_states;
+        // Bounds the memory of the layers if clause-memory is set.
+        std::unique_ptr<ClauseDatabase> clause_database;
+        // The clauses exchanged with the other searches of a portfolio, the
+        // index of this search and how far the clauses have been imported.
+        std::shared_ptr<SharedClauses> shared_clauses;
+        int portfolio_index = SharedClauses::NONE;
+        bool exchange_clauses = false;
+        std::size_t shared_position = 0;
+        // One workspace per extend thread, the first one is used by extend.
+        std::vector<ExtendWorkspace> workspaces;
+        // For every layer i the version of Li-1 when the clauses of its
+        // delta were last checked for pushing to Li. Whether a clause can
+        // be pushed only depends on Li-1, so the clauses that are still in
+        // the delta can only be pushed once Li-1 has changed.
+        std::vector<std::size_t> propagated_versions;
 
 
         int iteration = 0;
-        std::vector<LiteralSet> A_effect; 
+        // Operators compiled once in initialize. Forward they are indexed
+        // by operator id, backward A_task_operator gives the operator of
+        // the task.
+        std::vector<LiteralSet> A_precondition;
+        std::vector<LiteralSet> A_effect;
+        std::vector<int> A_task_operator;
+        // For every fact index the operators whose effect adds the fact
+        // and the operators whose effect sets its variable to another value.
+        std::vector<std::vector<int>> A_adding;
+        std::vector<std::vector<int>> A_deleting;
+        // The goal facts and the negated other values of their variables,
+        // backward the same for the initial state.
+        LiteralSet goal_cube = LiteralSet(SetType::CUBE);
+
+        // Returns the ids of the operators that make at least one literal
+        // of one of the clauses true in a state that violates them, in
+        // ascending order.
+        std::vector<int> collect_operators(const std::unordered_set<const LiteralSet *> &clauses,
+                                           ExtendWorkspace &workspace) const;
+        // Returns the ids of the operators whose effect makes a literal of c
+        // true, in ascending order.
+        // Unlike collect_operators, this needs no workspace, so it is safe to
+        // call from several threads.
+        std::vector<int> adding_operators(const LiteralSet &c) const;
+        // Returns true if clause c ∈ Li-1 can be pushed to Li, i.e. no operator
+        // leads from a state violating c to a state of Li-1.
+        bool can_push(const LiteralSet &c, const Layer &Li1) const;
+        // Returns true if the states of cube r can not reach the goal in i steps
+        // given that Li-1 contains the states that reach it in i-1 steps:
+        // r contains no goal state and every successor in Li-1 of a state
+        // of r is in r again. Approximated on the partial assignment r.
+        // States of r that are not in Li can not reach the goal in i steps
+        // anyway, so only the states of r in Li are considered.
+        bool is_relatively_inductive(const LiteralSet &r, const Layer &Li1, const Layer &Li) const;
+        // Drops literals of the reason r as long as it stays relatively
+        // inductive with respect to Li-1 (like MIC in IC3).
+        LiteralSet generalize(const LiteralSet &r, const Layer &Li1, const Layer &Li);
+        // Lifts the obligation s at layer i to the partial state of the
+        // variables of the smallest clause of Li-1 that s violates, which
+        // keeps all its states outside of Li-1. Returns it as reason if it
+        // is relatively inductive, then s does not need to be extended.
+        tl::optional<LiteralSet> block_lifted(const FullState &s, int i);
+        // Returns true if Li = Li+1 proves that no path leads from a source
+        // state to L0. This holds by the relative induction of the layers
+        // unless clauses were evicted from Li, then it is checked that no
+        // operator leads from a state outside of Li into Li and that Li
+        // contains no source state.
+        bool is_fixpoint(int i);
+        // Adds the clauses of the other searches of the portfolio to the
+        // layers in which they keep the layers relatively inductive.
+        void import_shared_clauses();
+        // Prints a line of progress output, prefixed with the index of the
+        // search in a portfolio, whose searches print concurrently.
+        void print_progress(const std::string &message) const;
+        // Unit propagation of the clauses of L on the partial assignment p.
+        // Returns false if p violates a clause of L.
+        bool propagate(LiteralSet &p, const Layer &L) const;
 
         std::shared_ptr<Layer> get_layer(long unsigned int i);
 
-        // Returns (t, true) where t is successor state
-        // or (r, false) where r is reason
-        std::pair<LiteralSet, bool> extend(const LiteralSet &s, const Layer &L);
+        // Adds the operators of the task in reverse: an operator a gives
+        // a backward operator from every state that a leads to, to the
+        // predecessor. Effects without precondition leave the predecessor
+        // open, so a is split for every combination of their values. Exits
+        // if an operator needs more than MAX_BACKWARD_SPLITS of them.
+        void add_backward_operators();
+        // Returns the state in which the path construction starts if it
+        // is in L: the initial state, or backward a goal state.
+        tl::optional<FullState> find_source_state(const Layer &L);
+
+        // Returns (t, _) where t is successor state
+        // or (nullopt, r) where r is reason
+        std::pair<tl::optional<FullState>, LiteralSet> extend(const FullState &s, const Layer &L);
+        // The enumeration of the operators behind extend. Several threads
+        // can call it with different workspaces if there is no successor
+        // evaluator.
+        std::pair<tl::optional<FullState>, LiteralSet> extend_explicit(const FullState &s, const Layer &L,
+                                                                       ExtendWorkspace &workspace) const;
+        // Extends the obligation si at layer i and the obligations that the
+        // queue returns next, if they are at layer i as well, concurrently
+        // with extend_threads threads. Obligations that already have an
+        // extension are skipped.
+        void extend_batch(int si, int i, std::unordered_map<int, Extension> &extensions);
 
     protected:
         virtual void initialize() override;
         virtual SearchStatus step() override;
+        // Runs the search of a portfolio in its own thread, like
+        // SearchEngine::search but without writing to the log that all
+        // searches share. The portfolio calls initialize before.
+        SearchStatus search_in_portfolio();
 
-        void extract_path(const std::shared_ptr<Obligation> goal_obligation, const LiteralSet initialState);
+        void extract_path(int goal_obligation);
 
     public:
         PDRSearch(const options::Options &opts);
@@ -63,14 +247,20 @@ namespace pdr_search
 
         virtual void print_statistics() const override;
 
-        // Coverts a state to a literal set as a cube
-        // Same as the Lits(s) function in the paper
-        LiteralSet from_state(const State &s) const;
+        // Makes this the search with the given index of a portfolio, it
+        // stops once another search of the portfolio has finished or the
+        // portfolio is stopped. If
+        // exchange is set, it publishes the clauses it learns and imports
+        // the clauses of the other searches before every iteration.
+        void join_portfolio(const std::shared_ptr<SharedClauses> &clauses, int index, bool exchange);
+        bool is_backward() const;
+
+        // Coverts a state to a full state.
+        // FullState::to_cube() gives the Lits(s) function in the paper
+        FullState from_state(const State &s) const;
 
         LiteralSet from_precondition(const PreconditionsProxy &pc) const;
         LiteralSet from_effect(const EffectsProxy &ep) const;
-
-        LiteralSet all_variables() const;
     };
 
     extern void add_options_to_parser(options::OptionParser &parser);
@@ -1,3 +1,4 @@
+#include "pdr_portfolio.h"
 #include "pdr_search.h"
 #include "search_common.h"
 
@@ -21,5 +22,24 @@ static shared_ptr<SearchEngine> _parse(OptionParser &parser) {
     return engine;
 }
 
+static shared_ptr<SearchEngine> _parse_portfolio(OptionParser &parser) {
+    parser.document_synopsis(
+        "property-directed reachability portfolio",
+        "Runs several pdr searches in parallel threads until the first one "
+        "finishes. The searches can share the clauses they learn.");
+
+    pdr_search::add_portfolio_options_to_parser(parser);
+    Options opts = parser.parse();
+    opts.verify_list_non_empty<shared_ptr<SearchEngine>>("searches");
+
+    shared_ptr<pdr_search::PDRPortfolio> engine;
+    if (!parser.dry_run()) {
+        engine = make_shared<pdr_search::PDRPortfolio>(opts);
+    }
+
+    return engine;
+}
+
 static Plugin<SearchEngine> _plugin("pdr", _parse);
+static Plugin<SearchEngine> _plugin_portfolio("pdr-portfolio", _parse_portfolio);
 }